@@ -1,5 +1,6 @@
 #!/usr/bin/bash
 # nothing fancy, just a script to run this file easily
-#
-gcc singly_linked_list_2.c -o a
+# pass the file to build, defaults to singly_linked_list_2.c
+# e.g ./run.sh unrolled_linked_list.c
+gcc ${1:-singly_linked_list_2.c} -pthread -o a
 ./a
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 /*
  * Implementation of a singly linked list
@@ -19,21 +21,115 @@ typedef struct ListNode {
 } ListNode;
 
 
+/* bytes of a slab nodes are carved out of */
+#define SLAB_SIZE (64 * 1024)
+
+/*
+ * NodeSlab - a block of memory nodes are carved out of
+ * @next: the slab allocated before this one
+ * @nodes: the nodes themselves
+ */
+typedef struct NodeSlab {
+	struct NodeSlab *next;
+	ListNode nodes[];
+} NodeSlab;
+
+#define SLAB_NODES ((SLAB_SIZE - sizeof(NodeSlab)) / sizeof(ListNode))
+
+/*
+ * NodePool - where the nodes of lists come from and go back to
+ * @slabs: the slabs of the pool, newest first
+ * @slab_used: nodes handed out of the newest slab so far
+ * @free_nodes: nodes removed from lists, chained through their next pointer,
+ * handed out again before any new slab memory
+ */
+typedef struct NodePool {
+	NodeSlab *slabs;
+	size_t slab_used;
+	ListNode *free_nodes;
+} NodePool;
+
+/*
+ * node_pool - the pool of the calling thread
+ * Lists here are nothing but a head pointer, there is no list to hang a pool on,
+ * so every thread has one shared by all the lists it works on.
+ * A list must only be changed by the thread that built it.
+ */
+static __thread NodePool node_pool;
+
 /*
  * INITIALIZE_NODE - helper function to initialize the node of a list
  * @node_value: value of the node to be initialized
  * Return: the created node or NULL on failure
+ * Description: a node freed by a removal is reused first, then the newest
+ * slab is carved, malloc is only called for a whole new slab
  */
 ListNode *INITIALIZE_NODE(int node_value)
 {
-	ListNode *new_node = malloc(sizeof(ListNode));
-	if (new_node == NULL)
-		return (NULL);
+	ListNode *new_node = node_pool.free_nodes;
+	if (new_node != NULL)
+		node_pool.free_nodes = new_node->next;
+	else
+	{
+		if (node_pool.slabs == NULL || node_pool.slab_used == SLAB_NODES)
+		{
+			NodeSlab *slab = malloc(SLAB_SIZE);
+			if (slab == NULL)
+				return (NULL);
+			slab->next = node_pool.slabs;
+			node_pool.slabs = slab;
+			node_pool.slab_used = 0;
+		}
+		new_node = &node_pool.slabs->nodes[node_pool.slab_used++];
+	}
 	new_node->value = node_value;
 	new_node->next = NULL;
 	return (new_node);
 }
 
+/*
+ * free_node - gives a node back to the pool
+ * @node: the node, no longer in any list
+ */
+void free_node(ListNode *node)
+{
+	node->next = node_pool.free_nodes;
+	node_pool.free_nodes = node;
+}
+
+/*
+ * list_destroy - gives every node of a list back to the pool
+ * @head: pointer to the first node of the list, set to NULL
+ */
+void list_destroy(ListNode **head)
+{
+	ListNode *current = *head;
+	while (current != NULL)
+	{
+		ListNode *next = current->next;
+		free_node(current);
+		current = next;
+	}
+	*head = NULL;
+}
+
+/*
+ * node_pool_release - frees the slabs of the calling thread's pool
+ * Description: every list the thread built must be destroyed (or forgotten)
+ * first, their nodes are released a whole slab at a time
+ */
+void node_pool_release(void)
+{
+	while (node_pool.slabs != NULL)
+	{
+		NodeSlab *next = node_pool.slabs->next;
+		free(node_pool.slabs);
+		node_pool.slabs = next;
+	}
+	node_pool.slab_used = 0;
+	node_pool.free_nodes = NULL;
+}
+
 /*
  * push - adds a new node to the end of a given list
  * @head: the first node of the list where the new node is being pushed
@@ -62,13 +158,15 @@ ListNode *push(ListNode **head, int new_node_value)
 /*
  * pop - removes a node at the end of the list
  * @head: the first node of the list whose last node is being removed
- * Return: NULL if there are no elements in the list or the removed node
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 0 if there are no elements in the list or 1 if a node was removed
+ * Description: the node goes back to the pool
  */
-ListNode *pop(ListNode **head)
+int pop(ListNode **head, int *value)
 {
-	/*Check if the list is empty, if it is, return NULL*/
+	/*Check if the list is empty, if it is, return 0*/
 	if (*head == NULL)
-		return (NULL);
+		return (0);
 	/*Otherwise, loop to the end of the list and remove the node*/
 	/*Use two pointers technique to do this*/
 	ListNode *temp_node = *head;
@@ -82,7 +180,6 @@ ListNode *pop(ListNode **head)
 	/*temp_node is pointing at the node previous to it*/
 	/*We loose reference of current_node by setting next of temp_node to NULL*/
 	temp_node->next = NULL;
-	/*TODO: Free the memory being occupied by current_node as we are removing it*/
 	/*
 	 * We also need to check if the list has only one node and it is the one node we are trying to remove
 	 * In this case, the list will be left with no elements
@@ -90,9 +187,11 @@ ListNode *pop(ListNode **head)
 	 */
 	if (temp_node == current_node)
 		/*set the list to null since it has no elements*/
-		/*TODO: Free the memory being occupied by the node*/
 		*head = NULL;
-	return (current_node);
+	if (value != NULL)
+		*value = current_node->value;
+	free_node(current_node);
+	return (1);
 }
 
 /*
@@ -121,26 +220,22 @@ ListNode *unshift(ListNode **head, int new_node_value)
 /*
  * shift - removes the first node of a given list
  * @head: pointer to the first node of the list we are shiftting
- * Return: the removed node or null on failure
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 on failure
+ * Description: the node goes back to the pool
  */
-ListNode *shift(ListNode **head)
+int shift(ListNode **head, int *value)
 {
-	/*If the list is empty, return NULL*/
+	/*If the list is empty, return 0*/
 	if (*head == NULL)
-		return (NULL);
+		return (0);
 	ListNode *current_head = *head;
-	/*Just an edge case handling: If the head is the only node (one node)*/
-	if (current_head->next == NULL)
-	{
-		*head = NULL;
-		return (current_head);
-		/*TODO: Free the memory being held by current head*/
-	}
+	/*The next of the only node is NULL, so this also empties a one node list*/
 	*head = current_head->next;
-	/*clear the reference being held by the current head*/
-	current_head->next = NULL;
-	/*TODO: Free the memory being held by current_head*/
-	return (current_head);
+	if (value != NULL)
+		*value = current_head->value;
+	free_node(current_head);
+	return (1);
 }
 
 /*
@@ -169,19 +264,17 @@ int get_list_length(ListNode **head)
  * @node_index: the index of the node we are want to retrieve
  * Return: the node retrieved or NULL if there is any failure
  * Description: uses zero-based indexing, the first element is index 0 and the last element is index length of the list minus 1
+ * The list is walked once, up to the index at most
   */
 ListNode *get_node(ListNode **head, int node_index)
 {
-	/*If the list is empty, we return NULL*/
-	if (*head == NULL)
-		return (NULL);
-	/*Check if the index is between 0 and length of the list minus 1*/
-	int list_length = get_list_length(head);
-	if (node_index < 0 || node_index >= list_length)
+	/*If the list is empty or the index negative, we return NULL*/
+	if (*head == NULL || node_index < 0)
 		return (NULL);
+	/*Walk to the index, running off the end means it is past the length*/
 	int current_index = 0;
 	ListNode *current_node = *head;
-	while (current_index != node_index)
+	while (current_node != NULL && current_index != node_index)
 	{
 		current_node = current_node->next;
 		current_index += 1;
@@ -206,24 +299,27 @@ ListNode *update_node(ListNode **head, int node_index, int new_value)
  * @insert_index: the index at which to insert the node
  * @new_node_value: the value of the new node to insert to the list
  * Return: the inserted node or NULL on failure
+ * Description: the index must be one of a node of the list, index
+ * length - 1 appends after the last node. The list is walked once
  */
 ListNode *insert(ListNode **head, int insert_index, int new_node_value)
 {
-	/*validate that the insert index is within ranges*/
-	int list_length = get_list_length(head);
-	if (insert_index < 0 || insert_index >= list_length)
+	/*validate that the insert index is within ranges, the list has to have a node there*/
+	if (*head == NULL || insert_index < 0)
 		return (NULL);
 	/*If the index is 0, the insert at head*/
 	if (insert_index == 0)
 		return (unshift(head, new_node_value));
-	/*if the index is list_length - 1, insert at the end*/
-	if (insert_index == list_length - 1)
-		return (push(head, new_node_value));
+	/*Get the element previous to the insert index, this is the only walk*/
+	ListNode *node_previous_to_insert_index = get_node(head, insert_index - 1);
+	if (node_previous_to_insert_index == NULL || node_previous_to_insert_index->next == NULL)
+		return (NULL);
 	ListNode *new_node = INITIALIZE_NODE(new_node_value);
 	if (new_node == NULL)
 		return (NULL);
-	/*Get the element previous to the insert index*/
-	ListNode *node_previous_to_insert_index = get_node(head, insert_index - 1);
+	/*if the index is list_length - 1, insert at the end, like push would*/
+	if (node_previous_to_insert_index->next->next == NULL)
+		node_previous_to_insert_index = node_previous_to_insert_index->next;
 	/*Store the node next to it to avoid loosing referece*/
 	ListNode *temp_next = node_previous_to_insert_index->next;
 	/*Set the node_previous_ to_insert_index's next to be the new node*/
@@ -237,31 +333,29 @@ ListNode *insert(ListNode **head, int insert_index, int new_node_value)
  * remove - removes a node from the middle of a list
  * @head: pointer to the first element of the list we are removing from
  * @removal_index: the index of the node we want to remove
- * Return: the removed node or NULL on failure
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 on failure
+ * Description: the node goes back to the pool. The list is walked once
  * */
-ListNode *remove_middle(ListNode **head, int removal_index)
+int remove_middle(ListNode **head, int removal_index, int *value)
 {
-	if (*head == NULL)
-		return (NULL);
 	/*do removal index validation*/
-	int list_length = get_list_length(head);
-	if (removal_index < 0 || removal_index >= list_length)
-		return (NULL);
+	if (*head == NULL || removal_index < 0)
+		return (0);
 	/*If the index is 0, shift*/
 	if (removal_index == 0)
-		return (shift(head));
-	if (removal_index == list_length - 1)
-		return (pop(head));
-	/*Store the node to be removed*/
-	ListNode *node_to_be_removed = get_node(head, removal_index);
-	/*Get the node previous to the node to be removed*/
+		return (shift(head, value));
+	/*Get the node previous to the node to be removed, this is the only walk*/
 	ListNode *temp_previous = get_node(head, removal_index - 1);
-	/*Get the node next to the node to be removed*/
-	ListNode *temp_next = get_node(head, removal_index + 1);
-	temp_previous->next = temp_next;
-	node_to_be_removed->next = NULL;
-	/*TODO: Free the memory occupied by node_to_be_removed*/
-	return (node_to_be_removed);
+	if (temp_previous == NULL || temp_previous->next == NULL)
+		return (0);
+	/*Store the node to be removed and link its previous to its next*/
+	ListNode *node_to_be_removed = temp_previous->next;
+	temp_previous->next = node_to_be_removed->next;
+	if (value != NULL)
+		*value = node_to_be_removed->value;
+	free_node(node_to_be_removed);
+	return (1);
 }
 
 /*
@@ -285,6 +379,554 @@ int traverse_list(ListNode **head)
 }
 
 
+/*
+ * IndexedList - a list with an index over it for positional access
+ * @head: first node of the list. After indexed_list_init the list may only be
+ * changed through the indexed_* functions, any other change leaves the index stale
+ * @length: number of nodes in the list
+ * @segment_heads: the list cut in runs of consecutive nodes, the first node of each
+ * @segment_lengths: the number of nodes of each run
+ * @segments: number of runs
+ * @capacity: room in segment_heads and segment_lengths
+ * @target: the run length aimed for, about the square root of the length
+ * Description: reaching index i means adding up run lengths until the run
+ * holding i, then walking inside that run, O(length / target + target) steps,
+ * which is O(sqrt(n)) instead of the O(n) of get_node.
+ * Runs longer than 2 * target are split and runs that fit in one are merged
+ * with their neighbour, and the whole index is rebuilt when the length
+ * outgrows the target, so the bounds hold as the list changes.
+ */
+typedef struct IndexedList {
+	ListNode *head;
+	int length;
+	ListNode **segment_heads;
+	int *segment_lengths;
+	int segments;
+	int capacity;
+	int target;
+} IndexedList;
+
+/*
+ * reserve_segments - makes room for a number of runs in an index
+ * @list: the indexed list
+ * @segments: the number of runs needed
+ * Return: 1 on success or 0 on failure
+ */
+int reserve_segments(IndexedList *list, int segments)
+{
+	if (segments <= list->capacity)
+		return (1);
+	int capacity = 2 * segments;
+	ListNode **heads = realloc(list->segment_heads, capacity * sizeof(ListNode *));
+	if (heads == NULL)
+		return (0);
+	list->segment_heads = heads;
+	int *lengths = realloc(list->segment_lengths, capacity * sizeof(int));
+	if (lengths == NULL)
+		return (0);
+	list->segment_lengths = lengths;
+	list->capacity = capacity;
+	return (1);
+}
+
+/*
+ * rebuild_index - recuts the list into runs of about sqrt(length) nodes
+ * @list: the indexed list, head and length must be right
+ * Return: 1 on success or 0 on failure
+ */
+int rebuild_index(IndexedList *list)
+{
+	int target = 16;
+	while (target * target < list->length)
+		target *= 2;
+	if (!reserve_segments(list, list->length / target + 1))
+		return (0);
+	list->target = target;
+	list->segments = 0;
+	int position = 0;
+	for (ListNode *current = list->head; current != NULL; current = current->next, position++)
+	{
+		if (position % target == 0)
+		{
+			list->segment_heads[list->segments] = current;
+			list->segment_lengths[list->segments++] = 0;
+		}
+		list->segment_lengths[list->segments - 1]++;
+	}
+	return (1);
+}
+
+/*
+ * indexed_list_init - puts an index over a list
+ * @list: the indexed list to set up
+ * @head: first node of the list, the indexed list takes it over
+ * Return: 1 on success or 0 on failure
+ */
+int indexed_list_init(IndexedList *list, ListNode *head)
+{
+	list->head = head;
+	list->length = get_list_length(&head);
+	list->segment_heads = NULL;
+	list->segment_lengths = NULL;
+	list->segments = 0;
+	list->capacity = 0;
+	return (rebuild_index(list));
+}
+
+/*
+ * indexed_list_destroy - gives every node of an indexed list back to the pool
+ * @list: the indexed list, it is left empty
+ */
+void indexed_list_destroy(IndexedList *list)
+{
+	list_destroy(&list->head);
+	free(list->segment_heads);
+	free(list->segment_lengths);
+	list->length = 0;
+	list->segment_heads = NULL;
+	list->segment_lengths = NULL;
+	list->segments = 0;
+	list->capacity = 0;
+}
+
+/*
+ * find_segment - finds the run holding an index
+ * @list: the indexed list, index must be within range
+ * @index: the index
+ * @offset: gets the position of the index within its run
+ * Return: the number of the run
+ */
+int find_segment(IndexedList *list, int index, int *offset)
+{
+	int segment = 0;
+	while (index >= list->segment_lengths[segment])
+		index -= list->segment_lengths[segment++];
+	*offset = index;
+	return (segment);
+}
+
+/*
+ * indexed_get_node - retrieves a node from an indexed list
+ * @list: the indexed list
+ * @node_index: the index of the node, zero based
+ * Return: the node or NULL if the index is out of range
+ */
+ListNode *indexed_get_node(IndexedList *list, int node_index)
+{
+	if (node_index < 0 || node_index >= list->length)
+		return (NULL);
+	int offset;
+	ListNode *current_node = list->segment_heads[find_segment(list, node_index, &offset)];
+	while (offset-- > 0)
+		current_node = current_node->next;
+	return (current_node);
+}
+
+/*
+ * drop_segment - takes a run out of the index
+ * @list: the indexed list
+ * @segment: the number of the run
+ */
+void drop_segment(IndexedList *list, int segment)
+{
+	memmove(&list->segment_heads[segment], &list->segment_heads[segment + 1],
+		(list->segments - segment - 1) * sizeof(ListNode *));
+	memmove(&list->segment_lengths[segment], &list->segment_lengths[segment + 1],
+		(list->segments - segment - 1) * sizeof(int));
+	list->segments--;
+}
+
+/*
+ * split_segment - cuts a run in two halves
+ * @list: the indexed list
+ * @segment: the number of the run
+ * Return: 1 on success or 0 on failure, the index is still right then
+ */
+int split_segment(IndexedList *list, int segment)
+{
+	if (!reserve_segments(list, list->segments + 1))
+		return (0);
+	const int half = list->segment_lengths[segment] / 2;
+	ListNode *second_head = list->segment_heads[segment];
+	for (int i = 0; i < half; i++)
+		second_head = second_head->next;
+	memmove(&list->segment_heads[segment + 2], &list->segment_heads[segment + 1],
+		(list->segments - segment - 1) * sizeof(ListNode *));
+	memmove(&list->segment_lengths[segment + 2], &list->segment_lengths[segment + 1],
+		(list->segments - segment - 1) * sizeof(int));
+	list->segment_heads[segment + 1] = second_head;
+	list->segment_lengths[segment + 1] = list->segment_lengths[segment] - half;
+	list->segment_lengths[segment] = half;
+	list->segments++;
+	return (1);
+}
+
+/*
+ * indexed_insert - inserts a node into an indexed list
+ * @list: the indexed list
+ * @insert_index: the index the new node gets, from 0 to the length
+ * @new_node_value: the value of the new node
+ * Return: the inserted node or NULL on failure
+ */
+ListNode *indexed_insert(IndexedList *list, int insert_index, int new_node_value)
+{
+	if (insert_index < 0 || insert_index > list->length)
+		return (NULL);
+	ListNode *new_node = INITIALIZE_NODE(new_node_value);
+	if (new_node == NULL)
+		return (NULL);
+	int segment = 0;
+	if (insert_index == 0)
+	{
+		new_node->next = list->head;
+		list->head = new_node;
+		if (list->segments == 0)
+		{
+			if (!reserve_segments(list, 1))
+			{
+				list->head = NULL;
+				free_node(new_node);
+				return (NULL);
+			}
+			list->segment_lengths[list->segments++] = 0;
+		}
+		list->segment_heads[0] = new_node;
+	}
+	else
+	{
+		/*the new node joins the run of the node before it*/
+		int offset;
+		segment = find_segment(list, insert_index - 1, &offset);
+		ListNode *node_before = list->segment_heads[segment];
+		while (offset-- > 0)
+			node_before = node_before->next;
+		new_node->next = node_before->next;
+		node_before->next = new_node;
+	}
+	list->segment_lengths[segment]++;
+	list->length++;
+	if (list->length > 4 * list->target * list->target)
+		rebuild_index(list);
+	else if (list->segment_lengths[segment] > 2 * list->target)
+		split_segment(list, segment);
+	return (new_node);
+}
+
+/*
+ * indexed_remove - removes a node from an indexed list
+ * @list: the indexed list
+ * @removal_index: the index of the node to remove
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 if the index is out of range
+ */
+int indexed_remove(IndexedList *list, int removal_index, int *value)
+{
+	if (removal_index < 0 || removal_index >= list->length)
+		return (0);
+	int offset;
+	const int segment = find_segment(list, removal_index, &offset);
+	ListNode *node_to_be_removed;
+	if (removal_index == 0)
+	{
+		node_to_be_removed = list->head;
+		list->head = node_to_be_removed->next;
+	}
+	else
+	{
+		/*the node before is the last of the previous run when offset is 0*/
+		int before_offset;
+		const int before_segment = find_segment(list, removal_index - 1, &before_offset);
+		ListNode *node_before = list->segment_heads[before_segment];
+		while (before_offset-- > 0)
+			node_before = node_before->next;
+		node_to_be_removed = node_before->next;
+		node_before->next = node_to_be_removed->next;
+	}
+	if (offset == 0)
+		list->segment_heads[segment] = node_to_be_removed->next;
+	list->length--;
+	if (--list->segment_lengths[segment] == 0)
+		drop_segment(list, segment);
+	else if (segment + 1 < list->segments &&
+		 list->segment_lengths[segment] + list->segment_lengths[segment + 1] <= list->target)
+	{
+		list->segment_lengths[segment] += list->segment_lengths[segment + 1];
+		drop_segment(list, segment + 1);
+	}
+	if (list->target > 16 && 16 * list->length < list->target * list->target)
+		rebuild_index(list);
+	if (value != NULL)
+		*value = node_to_be_removed->value;
+	free_node(node_to_be_removed);
+	return (1);
+}
+
+/*
+ * merge_runs - merges two sorted lists by relinking their nodes
+ * @first: a sorted list
+ * @second: a sorted list, on equal values its nodes go after those of first
+ * @tail: if not NULL, gets the last node of the merged list
+ * Return: the first node of the merged list
+ */
+ListNode *merge_runs(ListNode *first, ListNode *second, ListNode **tail)
+{
+	ListNode merged;
+	ListNode *last = &merged;
+	while (first != NULL && second != NULL)
+	{
+		if (second->value < first->value)
+		{
+			last->next = second;
+			second = second->next;
+		}
+		else
+		{
+			last->next = first;
+			first = first->next;
+		}
+		last = last->next;
+	}
+	last->next = first != NULL ? first : second;
+	if (tail != NULL)
+	{
+		while (last->next != NULL)
+			last = last->next;
+		*tail = last == &merged ? NULL : last;
+	}
+	return (merged.next);
+}
+
+/* enough bins for a run of 2^63 nodes */
+#define SORT_BINS 64
+
+/*
+ * sort_run - sorts a list by relinking its nodes
+ * @head: first node of the list
+ * @tail: if not NULL, gets the last node of the sorted list
+ * Return: the first node of the sorted list
+ * Description: a bottom-up merge sort with no recursion and no allocation,
+ * bins[i] holds a sorted run of 2^i nodes, each node is carried up the bins
+ * merging the runs it meets, like adding one to a binary counter.
+ * It is stable and only ever merges runs of close lengths
+ */
+ListNode *sort_run(ListNode *head, ListNode **tail)
+{
+	ListNode *bins[SORT_BINS] = {NULL};
+	int used = 0;
+	while (head != NULL)
+	{
+		ListNode *run = head;
+		head = head->next;
+		run->next = NULL;
+		int bin = 0;
+		/*the runs in the bins hold earlier nodes, they go first for stability*/
+		for (; bin < used && bins[bin] != NULL; bin++)
+		{
+			run = merge_runs(bins[bin], run, NULL);
+			bins[bin] = NULL;
+		}
+		if (bin == used)
+			used++;
+		bins[bin] = run;
+	}
+	ListNode *sorted = NULL;
+	ListNode *last = NULL;
+	for (int bin = 0; bin < used; bin++)
+	{
+		if (bins[bin] == NULL)
+			continue;
+		if (sorted == NULL)
+			sorted = bins[bin];
+		else
+			sorted = merge_runs(bins[bin], sorted, &last);
+	}
+	if (tail != NULL)
+	{
+		/*a single bin means no final merge found the tail*/
+		if (last == NULL && sorted != NULL)
+			for (last = sorted; last->next != NULL; last = last->next)
+				;
+		*tail = last;
+	}
+	return (sorted);
+}
+
+/*
+ * cut_after - cuts a list in two
+ * @head: first node of the list
+ * @count: number of nodes to keep in the first part
+ * Return: the first node of the second part or NULL if there is none
+ */
+ListNode *cut_after(ListNode *head, int count)
+{
+	if (head == NULL || count <= 0)
+		return (head);
+	while (--count > 0 && head->next != NULL)
+		head = head->next;
+	ListNode *rest = head->next;
+	head->next = NULL;
+	return (rest);
+}
+
+/* the most threads a parallel sort uses */
+#define SORT_MAX_THREADS 64
+/* shortest list a thread of a parallel sort gets, shorter ones are sorted by one thread */
+#define PARALLEL_MIN_SORT 65536
+
+/*
+ * SortWorker - a part of a parallel sort one thread does
+ * @first: the list to sort, or the first one of two to merge, the result after
+ * @second: NULL to sort first or the second list to merge into it
+ * @tail: last node of the result
+ */
+typedef struct SortWorker {
+	ListNode *first;
+	ListNode *second;
+	ListNode *tail;
+} SortWorker;
+
+/*
+ * sort_worker - sorts or merges the lists of a SortWorker
+ * @arg: the SortWorker
+ * Return: NULL
+ */
+void *sort_worker(void *arg)
+{
+	SortWorker *worker = arg;
+	if (worker->second == NULL)
+		worker->first = sort_run(worker->first, &worker->tail);
+	else
+		worker->first = merge_runs(worker->first, worker->second, &worker->tail);
+	return (NULL);
+}
+
+/*
+ * run_workers - runs SortWorkers on their own threads
+ * @workers: the workers
+ * @count: number of workers
+ * Description: a worker whose thread cannot start runs on the calling thread
+ */
+void run_workers(SortWorker *workers, int count)
+{
+	pthread_t threads[SORT_MAX_THREADS];
+	int started[SORT_MAX_THREADS];
+	for (int i = 1; i < count; i++)
+		started[i] = pthread_create(&threads[i], NULL, sort_worker, &workers[i]) == 0;
+	sort_worker(&workers[0]);
+	for (int i = 1; i < count; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			sort_worker(&workers[i]);
+	}
+}
+
+/*
+ * sort_parallel - sorts a list on several threads
+ * @head: first node of the list
+ * @length: number of nodes in the list
+ * @threads: number of threads to use
+ * @tail: gets the last node of the sorted list
+ * Return: the first node of the sorted list
+ * Description: the list is cut in one part per thread, the parts are sorted
+ * side by side, then merged by pairs, each round of merges side by side too
+ */
+ListNode *sort_parallel(ListNode *head, int length, int threads, ListNode **tail)
+{
+	if (threads > SORT_MAX_THREADS)
+		threads = SORT_MAX_THREADS;
+	if (threads > length / PARALLEL_MIN_SORT)
+		threads = length / PARALLEL_MIN_SORT;
+	if (threads < 2)
+		return (sort_run(head, tail));
+	SortWorker workers[SORT_MAX_THREADS];
+	for (int i = 0; i < threads; i++)
+	{
+		workers[i].first = head;
+		workers[i].second = NULL;
+		head = cut_after(head, length / threads + (i < length % threads));
+	}
+	run_workers(workers, threads);
+	while (threads > 1)
+	{
+		const int pairs = threads / 2;
+		for (int i = 0; i < pairs; i++)
+		{
+			ListNode *first = workers[2 * i].first;
+			ListNode *second = workers[2 * i + 1].first;
+			workers[i].first = first;
+			workers[i].second = second;
+		}
+		run_workers(workers, pairs);
+		/*an odd part out waits for the next round*/
+		if (threads % 2)
+			workers[pairs] = workers[threads - 1];
+		threads = (threads + 1) / 2;
+	}
+	*tail = workers[0].tail;
+	return (workers[0].first);
+}
+
+/*
+ * list_sort - sorts a list in ascending order
+ * @head: pointer to the head of the list
+ * Description: the nodes are relinked, nothing is allocated, see sort_run
+ */
+void list_sort(ListNode **head)
+{
+	*head = sort_run(*head, NULL);
+}
+
+/*
+ * list_sort_parallel - sorts a list in ascending order on several threads
+ * @head: pointer to the head of the list
+ * @threads: number of threads to use, lists too short to share are sorted by one
+ */
+void list_sort_parallel(ListNode **head, int threads)
+{
+	ListNode *tail;
+	*head = sort_parallel(*head, get_list_length(head), threads, &tail);
+}
+
+/*
+ * merge_sorted - merges a sorted list into another
+ * @head: pointer to the head of a sorted list, it gets the merged list
+ * @other: pointer to the head of a sorted list, it is left empty
+ */
+void merge_sorted(ListNode **head, ListNode **other)
+{
+	if (head == other)
+		return;
+	*head = merge_runs(*head, *other, NULL);
+	*other = NULL;
+}
+
+/*
+ * dedupe_sorted - removes the repeated values of a sorted list
+ * @head: pointer to the head of the list
+ * Return: number of nodes removed
+ * Description: the first node of each value is kept, the others go back to the pool
+ */
+int dedupe_sorted(ListNode **head)
+{
+	int removed = 0;
+	ListNode *current = *head;
+	while (current != NULL && current->next != NULL)
+	{
+		ListNode *next = current->next;
+		if (next->value == current->value)
+		{
+			current->next = next->next;
+			free_node(next);
+			removed++;
+		}
+		else
+			current = next;
+	}
+	return (removed);
+}
+
 int main()
 {
 	printf("===Singly Linked Lists===\n");
@@ -295,15 +937,15 @@ int main()
 	push(&head, 35);
 
 
-	pop(&head);
+	pop(&head, NULL);
 
 	unshift(&head, 10);
 	unshift(&head, 5);
 	unshift(&head, 3);
 	unshift(&head, 0);
 
-	shift(&head);
-	shift(&head);
+	shift(&head, NULL);
+	shift(&head, NULL);
 
 	update_node(&head, 1, 9);
 	update_node(&head, 4, 35);
@@ -313,14 +955,45 @@ int main()
 	insert(&head, 6, 40);
 	insert(&head, 6, 30);
 
-	remove_middle(&head, 0);
-	remove_middle(&head, 7);
-	remove_middle(&head, 2);
-	remove_middle(&head, 1);
+	remove_middle(&head, 0, NULL);
+	remove_middle(&head, 7, NULL);
+	remove_middle(&head, 2, NULL);
+	remove_middle(&head, 1, NULL);
 
 	printf("val: %d\n", get_node(&head, 4)->value);
 
 	printf("Length of the list: %d\n", get_list_length(&head));
 	traverse_list(&head);
+
+	/*the same kind of edits by index, on a long list with an index over it*/
+	IndexedList indexed;
+	ListNode *long_list = NULL;
+	for (int i = 0; i < 100000; i++)
+		unshift(&long_list, 99999 - i);
+	indexed_list_init(&indexed, long_list);
+	for (int i = 0; i < 10000; i++)
+	{
+		indexed_insert(&indexed, (i * 7919) % indexed.length, -i);
+		indexed_remove(&indexed, (i * 104729) % indexed.length, NULL);
+	}
+	printf("\nIndexed list: length %d in %d runs, node at 50000: %d\n", indexed.length,
+	       indexed.segments, indexed_get_node(&indexed, 50000)->value);
+	indexed_list_destroy(&indexed);
+
+	/*sort two lists, one on several threads, then merge them and drop repeats*/
+	/*300000 nodes in evens, enough for 4 threads of PARALLEL_MIN_SORT nodes each*/
+	ListNode *odds = NULL;
+	ListNode *evens = NULL;
+	for (int i = 0; i < 600000; i++)
+		unshift(i % 2 ? &odds : &evens, (int)((i * 2654435761u) % 1000));
+	list_sort(&odds);
+	list_sort_parallel(&evens, 4);
+	merge_sorted(&odds, &evens);
+	int removed = dedupe_sorted(&odds);
+	printf("Sorted and merged: %d values left, %d repeats removed, first %d last %d\n",
+	       get_list_length(&odds), removed, odds->value, get_node(&odds, get_list_length(&odds) - 1)->value);
+	list_destroy(&odds);
+	list_destroy(&head);
+	node_pool_release();
 	return (0);
 }
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <pthread.h>
 /*
  * Another flavor of implementation for singly linked list
  * Here, we keep track of the list
@@ -16,33 +17,92 @@ typedef struct ListNode{
 	struct ListNode *next;
 } ListNode;
 
+/* bytes of a slab nodes are carved out of */
+#define SLAB_SIZE (64 * 1024)
+
+/*
+ * NodeSlab - a block of memory nodes are carved out of
+ * @next: the slab allocated before this one
+ * @nodes: the nodes themselves
+ */
+typedef struct NodeSlab {
+	struct NodeSlab *next;
+	ListNode nodes[];
+} NodeSlab;
+
+#define SLAB_NODES ((SLAB_SIZE - sizeof(NodeSlab)) / sizeof(ListNode))
+
+/*
+ * NodePool - where the nodes of a list come from and go back to
+ * @slabs: the slabs of the pool, newest first
+ * @slab_used: nodes handed out of the newest slab so far
+ * @free_nodes: nodes removed from the list, chained through their next pointer,
+ * handed out again before any new slab memory
+ */
+typedef struct NodePool {
+	NodeSlab *slabs;
+	size_t slab_used;
+	ListNode *free_nodes;
+} NodePool;
+
 /*
  * SinglyLinkedList - structure of a singly linked list
  * @head: first node in the list
  * @tail: last node in the list
  * @length: number of nodes in the list
+ * @pool: the memory of the nodes of the list
+ * Description: a zeroed SL_List is an empty list
  */
 typedef struct SinglyLinkedList{
 	ListNode *head;
 	ListNode *tail;
 	int length;
+	NodePool pool;
 } SL_List;
 
 /*
  * INITIALIZE_NODE - reusable function to initialize a node
+ * @list: the list the node is for, it comes from the list's pool
  * @value: the value of the new node
  * Return: the initialized node or null on failure
+ * Description: a node freed by a removal is reused first, then the newest
+ * slab is carved, malloc is only called for a whole new slab
  */
-ListNode *INITIALIZE_NODE(int value)
+ListNode *INITIALIZE_NODE(SL_List *list, int value)
 {
-	ListNode *new_node = malloc(sizeof(ListNode));
-	if (new_node == NULL)
-		return (NULL);
+	NodePool *pool = &list->pool;
+	ListNode *new_node = pool->free_nodes;
+	if (new_node != NULL)
+		pool->free_nodes = new_node->next;
+	else
+	{
+		if (pool->slabs == NULL || pool->slab_used == SLAB_NODES)
+		{
+			NodeSlab *slab = malloc(SLAB_SIZE);
+			if (slab == NULL)
+				return (NULL);
+			slab->next = pool->slabs;
+			pool->slabs = slab;
+			pool->slab_used = 0;
+		}
+		new_node = &pool->slabs->nodes[pool->slab_used++];
+	}
 	new_node->value = value;
 	new_node->next = NULL;
 	return (new_node);
 }
 
+/*
+ * free_node - gives a node back to its list's pool
+ * @list: the list the node was removed from
+ * @node: the node
+ */
+void free_node(SL_List *list, ListNode *node)
+{
+	node->next = list->pool.free_nodes;
+	list->pool.free_nodes = node;
+}
+
 /*
  * reset_list - resets a lists back to its defaults
  * @list: the list to be reset
@@ -54,6 +114,24 @@ void reset_list(SL_List *list)
 	list->length = 0;
 }
 
+/*
+ * list_destroy - frees every node of a list
+ * @list: the list, it is left empty and can be used again
+ * Description: the nodes are released a whole slab at a time
+ */
+void list_destroy(SL_List *list)
+{
+	while (list->pool.slabs != NULL)
+	{
+		NodeSlab *next = list->pool.slabs->next;
+		free(list->pool.slabs);
+		list->pool.slabs = next;
+	}
+	list->pool.slab_used = 0;
+	list->pool.free_nodes = NULL;
+	reset_list(list);
+}
+
 /*
  * push - adds a new node to the end of a given list
  * @list: the list to which we are adding the new node
@@ -62,7 +140,7 @@ void reset_list(SL_List *list)
  */
 ListNode *push(SL_List *list, int new_node_value)
 {
-	ListNode *new_node = INITIALIZE_NODE(new_node_value);
+	ListNode *new_node = INITIALIZE_NODE(list, new_node_value);
 	if (new_node == NULL)
 		return (NULL);
 	/*If the list is empty, make this node the head and the tail*/
@@ -87,13 +165,15 @@ ListNode *push(SL_List *list, int new_node_value)
 /*
  * pop - removes the last node of a list
  * @list: the list from which the last node is being removed
- * Return: the removed node or NULL if there are no nodes
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 if there are no nodes
+ * Description: the node goes back to the list's pool
  */
-ListNode *pop(SL_List *list)
+int pop(SL_List *list, int *value)
 {
-	/*If there are no elements in the lis, return NULL*/
+	/*If there are no elements in the lis, return 0*/
 	if (!list->head || list->length == 0)
-		return (NULL);
+		return (0);
 	/*Use two pointers to removed the last node*/
 	ListNode *tmp_pointer = list->head;
 	ListNode *current_pointer = list->head;
@@ -102,19 +182,23 @@ ListNode *pop(SL_List *list)
 	if (list->length == 1)
 	{
 		reset_list(list);
-		return (current_pointer);
-		/*TODO: free the memory*/
 	}
-	/*Otherwise, we will work with the two pointer algorithm to get the last node*/
-	while (current_pointer->next != NULL)
+	else
 	{
-		tmp_pointer = current_pointer;
-		current_pointer = current_pointer->next;
+		/*Otherwise, we will work with the two pointer algorithm to get the last node*/
+		while (current_pointer->next != NULL)
+		{
+			tmp_pointer = current_pointer;
+			current_pointer = current_pointer->next;
+		}
+		tmp_pointer->next = NULL;
+		list->length--;
+		list->tail = tmp_pointer;
 	}
-	tmp_pointer->next = NULL;
-	list->length--;
-	list->tail = tmp_pointer;
-	return (current_pointer);
+	if (value != NULL)
+		*value = current_pointer->value;
+	free_node(list, current_pointer);
+	return (1);
 }
 
 /*
@@ -125,7 +209,7 @@ ListNode *pop(SL_List *list)
  */
 ListNode *unshift(SL_List *list, int new_node_value)
 {
-	ListNode *new_node = INITIALIZE_NODE(new_node_value);
+	ListNode *new_node = INITIALIZE_NODE(list, new_node_value);
 	if (new_node == NULL)
 		return (NULL);
 	/*If the list is empty, this node becomes the head and the tail*/
@@ -147,30 +231,33 @@ ListNode *unshift(SL_List *list, int new_node_value)
 /*
  * shift - removes the first node of a list
  * @list: the list from which the first node is being removed
- * Return: the removed node or null on failure
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 if there are no nodes
+ * Description: the node goes back to the list's pool
  */
-ListNode *shift(SL_List *list)
+int shift(SL_List *list, int *value)
 {
-	/*If there are no elements in the list, return NULL*/
+	/*If there are no elements in the list, return 0*/
 	if (!list->head || list->length == 0)
-		return (NULL);
+		return (0);
 	/*Save the first element in a variable*/
 	ListNode *current_first = list->head;
-	/*If the list has a length of 1, reset it and return the removed element*/
+	/*If the list has a length of 1, reset it*/
 	if (list->length == 1)
 	{
 		reset_list(list);
-		return (current_first);
-		/*TODO: free the memory*/
 	}
-	/*Otherwise, set the head to be next of the current head*/
-	/*Then set the next of the being removed head to NULL*/
-	/*Reduce the length by 1 and return it*/
-	list->head = current_first->next;
-	current_first->next = NULL;
-	list->length--;
-	return (current_first);
-	/*TODO: free the memory*/
+	else
+	{
+		/*Otherwise, set the head to be next of the current head*/
+		/*Reduce the length by 1*/
+		list->head = current_first->next;
+		list->length--;
+	}
+	if (value != NULL)
+		*value = current_first->value;
+	free_node(list, current_first);
+	return (1);
 }
 
 /*
@@ -242,7 +329,7 @@ ListNode *insert_middle(SL_List *list, int index, int node_value)
 	/*Use get_node method to get_node to get the node before the insert index*/
 	/*Make it point to the new_node*/
 	/*Make the new node point to what the other node was pointing to*/
-	ListNode *new_node = INITIALIZE_NODE(node_value);
+	ListNode *new_node = INITIALIZE_NODE(list, node_value);
 	if (new_node == NULL)
 		return (NULL);
 	ListNode *node_before = get_node(list, index - 1);
@@ -257,34 +344,37 @@ ListNode *insert_middle(SL_List *list, int index, int node_value)
  * remove_from_middle - removes a node from the middle of a list
  * @list: the list from which a node is being removed at the middle
  * @index: the index of the node to be removed
- * Return: the removed node or null on failure
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 on failure
+ * Description: the node goes back to the list's pool
  */
-ListNode *remove_from_middle(SL_List *list, int index)
+int remove_from_middle(SL_List *list, int index, int *value)
 {
-	/*If the list is empty, return NULL*/
+	/*If the list is empty, return 0*/
 	if (!list->head || list->length == 0)
-		return (NULL);
+		return (0);
 	/*validate the index*/
 	if (index < 0 || index >= list->length)
-		return (NULL);
+		return (0);
 	/*If the index is 0, shift*/
 	if (index == 0)
-		return (shift(list));
+		return (shift(list, value));
 	/*If the index equal to length - 1, pop*/
 	if (index == list->length - 1)
-		return (pop(list));
+		return (pop(list, value));
 	/*Get the node to be removed, the node before and the node after*/
 	ListNode *node_to_be_removed = get_node(list, index);
 	ListNode *node_before = get_node(list, index - 1);
 	ListNode *node_after = get_node(list, index + 1);
 
 	/*Make the node before to point to the node after*/
-	/*Make the node to be removed's next to be NULL*/
-	/*Reduce the length and return the removed node*/
+	/*Reduce the length and give the removed node back*/
 	node_before->next = node_after;
-	node_to_be_removed->next = NULL;
 	list->length--;
-	return (node_to_be_removed);
+	if (value != NULL)
+		*value = node_to_be_removed->value;
+	free_node(list, node_to_be_removed);
+	return (1);
 }
 
 /*
@@ -304,10 +394,405 @@ int traverse(SL_List *list)
 	printf("NULL\n");
 }
 
+/*
+ * SL_Cursor - a position in a list that edits can be made at
+ * @list: the list the cursor walks
+ * @previous: the node before the current one, NULL at the head
+ * @current: the node the cursor is on, NULL past the end
+ * Description: knowing the node before the current one, inserting after or
+ * removing the current node needs no walk from the head, so a pass that
+ * filters and rewrites a list as it goes is O(n) and not O(n^2) as with
+ * insert_middle and remove_from_middle
+ */
+typedef struct SL_Cursor {
+	SL_List *list;
+	ListNode *previous;
+	ListNode *current;
+} SL_Cursor;
+
+/*
+ * sl_cursor_begin - puts a cursor on the first node of a list
+ * @cursor: the cursor
+ * @list: the list to walk
+ * Return: the first node or NULL if the list is empty
+ */
+ListNode *sl_cursor_begin(SL_Cursor *cursor, SL_List *list)
+{
+	cursor->list = list;
+	cursor->previous = NULL;
+	cursor->current = list->head;
+	return (cursor->current);
+}
+
+/*
+ * sl_cursor_next - moves a cursor to the next node
+ * @cursor: the cursor
+ * Return: the node moved to or NULL once past the end
+ */
+ListNode *sl_cursor_next(SL_Cursor *cursor)
+{
+	if (cursor->current == NULL)
+		return (NULL);
+	cursor->previous = cursor->current;
+	cursor->current = cursor->current->next;
+	return (cursor->current);
+}
+
+/*
+ * sl_cursor_insert_after - inserts a node after the cursor's node
+ * @cursor: the cursor, it stays on its node
+ * @node_value: the value of the new node
+ * Return: the new node or NULL on failure
+ * Description: past the end the node is pushed, the new node is the one
+ * sl_cursor_next moves to, or the one the cursor is on when it was past the end
+ */
+ListNode *sl_cursor_insert_after(SL_Cursor *cursor, int node_value)
+{
+	SL_List *list = cursor->list;
+	if (cursor->current == NULL)
+	{
+		cursor->current = push(list, node_value);
+		return (cursor->current);
+	}
+	ListNode *new_node = INITIALIZE_NODE(list, node_value);
+	if (new_node == NULL)
+		return (NULL);
+	new_node->next = cursor->current->next;
+	cursor->current->next = new_node;
+	/*Inserting after the tail makes a new tail*/
+	if (list->tail == cursor->current)
+		list->tail = new_node;
+	list->length++;
+	return (new_node);
+}
+
+/*
+ * sl_cursor_remove - removes the cursor's node
+ * @cursor: the cursor, it moves to the node after the removed one
+ * @value: if not NULL, gets the value of the removed node
+ * Return: 1 if a node was removed or 0 if the cursor is past the end
+ * Description: the node goes back to the list's pool
+ */
+int sl_cursor_remove(SL_Cursor *cursor, int *value)
+{
+	SL_List *list = cursor->list;
+	ListNode *node_to_be_removed = cursor->current;
+	if (node_to_be_removed == NULL)
+		return (0);
+	/*Link the node before to the node after, the head has none before it*/
+	if (cursor->previous == NULL)
+		list->head = node_to_be_removed->next;
+	else
+		cursor->previous->next = node_to_be_removed->next;
+	if (list->tail == node_to_be_removed)
+		list->tail = cursor->previous;
+	list->length--;
+	cursor->current = node_to_be_removed->next;
+	if (value != NULL)
+		*value = node_to_be_removed->value;
+	free_node(list, node_to_be_removed);
+	return (1);
+}
+
+/*
+ * merge_runs - merges two sorted lists by relinking their nodes
+ * @first: a sorted list
+ * @second: a sorted list, on equal values its nodes go after those of first
+ * @tail: if not NULL, gets the last node of the merged list
+ * Return: the first node of the merged list
+ */
+ListNode *merge_runs(ListNode *first, ListNode *second, ListNode **tail)
+{
+	ListNode merged;
+	ListNode *last = &merged;
+	while (first != NULL && second != NULL)
+	{
+		if (second->value < first->value)
+		{
+			last->next = second;
+			second = second->next;
+		}
+		else
+		{
+			last->next = first;
+			first = first->next;
+		}
+		last = last->next;
+	}
+	last->next = first != NULL ? first : second;
+	if (tail != NULL)
+	{
+		while (last->next != NULL)
+			last = last->next;
+		*tail = last == &merged ? NULL : last;
+	}
+	return (merged.next);
+}
+
+/* enough bins for a run of 2^63 nodes */
+#define SORT_BINS 64
+
+/*
+ * sort_run - sorts a list by relinking its nodes
+ * @head: first node of the list
+ * @tail: if not NULL, gets the last node of the sorted list
+ * Return: the first node of the sorted list
+ * Description: a bottom-up merge sort with no recursion and no allocation,
+ * bins[i] holds a sorted run of 2^i nodes, each node is carried up the bins
+ * merging the runs it meets, like adding one to a binary counter.
+ * It is stable and only ever merges runs of close lengths
+ */
+ListNode *sort_run(ListNode *head, ListNode **tail)
+{
+	ListNode *bins[SORT_BINS] = {NULL};
+	int used = 0;
+	while (head != NULL)
+	{
+		ListNode *run = head;
+		head = head->next;
+		run->next = NULL;
+		int bin = 0;
+		/*the runs in the bins hold earlier nodes, they go first for stability*/
+		for (; bin < used && bins[bin] != NULL; bin++)
+		{
+			run = merge_runs(bins[bin], run, NULL);
+			bins[bin] = NULL;
+		}
+		if (bin == used)
+			used++;
+		bins[bin] = run;
+	}
+	ListNode *sorted = NULL;
+	ListNode *last = NULL;
+	for (int bin = 0; bin < used; bin++)
+	{
+		if (bins[bin] == NULL)
+			continue;
+		if (sorted == NULL)
+			sorted = bins[bin];
+		else
+			sorted = merge_runs(bins[bin], sorted, &last);
+	}
+	if (tail != NULL)
+	{
+		/*a single bin means no final merge found the tail*/
+		if (last == NULL && sorted != NULL)
+			for (last = sorted; last->next != NULL; last = last->next)
+				;
+		*tail = last;
+	}
+	return (sorted);
+}
+
+/*
+ * cut_after - cuts a list in two
+ * @head: first node of the list
+ * @count: number of nodes to keep in the first part
+ * Return: the first node of the second part or NULL if there is none
+ */
+ListNode *cut_after(ListNode *head, int count)
+{
+	if (head == NULL || count <= 0)
+		return (head);
+	while (--count > 0 && head->next != NULL)
+		head = head->next;
+	ListNode *rest = head->next;
+	head->next = NULL;
+	return (rest);
+}
+
+/* the most threads a parallel sort uses */
+#define SORT_MAX_THREADS 64
+/* shortest list a thread of a parallel sort gets, shorter ones are sorted by one thread */
+#define PARALLEL_MIN_SORT 65536
+
+/*
+ * SortWorker - a part of a parallel sort one thread does
+ * @first: the list to sort, or the first one of two to merge, the result after
+ * @second: NULL to sort first or the second list to merge into it
+ * @tail: last node of the result
+ */
+typedef struct SortWorker {
+	ListNode *first;
+	ListNode *second;
+	ListNode *tail;
+} SortWorker;
+
+/*
+ * sort_worker - sorts or merges the lists of a SortWorker
+ * @arg: the SortWorker
+ * Return: NULL
+ */
+void *sort_worker(void *arg)
+{
+	SortWorker *worker = arg;
+	if (worker->second == NULL)
+		worker->first = sort_run(worker->first, &worker->tail);
+	else
+		worker->first = merge_runs(worker->first, worker->second, &worker->tail);
+	return (NULL);
+}
+
+/*
+ * run_workers - runs SortWorkers on their own threads
+ * @workers: the workers
+ * @count: number of workers
+ * Description: a worker whose thread cannot start runs on the calling thread
+ */
+void run_workers(SortWorker *workers, int count)
+{
+	pthread_t threads[SORT_MAX_THREADS];
+	int started[SORT_MAX_THREADS];
+	for (int i = 1; i < count; i++)
+		started[i] = pthread_create(&threads[i], NULL, sort_worker, &workers[i]) == 0;
+	sort_worker(&workers[0]);
+	for (int i = 1; i < count; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			sort_worker(&workers[i]);
+	}
+}
+
+/*
+ * sort_parallel - sorts a list on several threads
+ * @head: first node of the list
+ * @length: number of nodes in the list
+ * @threads: number of threads to use
+ * @tail: gets the last node of the sorted list
+ * Return: the first node of the sorted list
+ * Description: the list is cut in one part per thread, the parts are sorted
+ * side by side, then merged by pairs, each round of merges side by side too
+ */
+ListNode *sort_parallel(ListNode *head, int length, int threads, ListNode **tail)
+{
+	if (threads > SORT_MAX_THREADS)
+		threads = SORT_MAX_THREADS;
+	if (threads > length / PARALLEL_MIN_SORT)
+		threads = length / PARALLEL_MIN_SORT;
+	if (threads < 2)
+		return (sort_run(head, tail));
+	SortWorker workers[SORT_MAX_THREADS];
+	for (int i = 0; i < threads; i++)
+	{
+		workers[i].first = head;
+		workers[i].second = NULL;
+		head = cut_after(head, length / threads + (i < length % threads));
+	}
+	run_workers(workers, threads);
+	while (threads > 1)
+	{
+		const int pairs = threads / 2;
+		for (int i = 0; i < pairs; i++)
+		{
+			ListNode *first = workers[2 * i].first;
+			ListNode *second = workers[2 * i + 1].first;
+			workers[i].first = first;
+			workers[i].second = second;
+		}
+		run_workers(workers, pairs);
+		/*an odd part out waits for the next round*/
+		if (threads % 2)
+			workers[pairs] = workers[threads - 1];
+		threads = (threads + 1) / 2;
+	}
+	*tail = workers[0].tail;
+	return (workers[0].first);
+}
+
+/*
+ * list_sort - sorts a list in ascending order
+ * @list: the list to sort
+ * Description: the nodes are relinked, nothing is allocated, see sort_run
+ */
+void list_sort(SL_List *list)
+{
+	list->head = sort_run(list->head, &list->tail);
+}
+
+/*
+ * list_sort_parallel - sorts a list in ascending order on several threads
+ * @list: the list to sort
+ * @threads: number of threads to use, lists too short to share are sorted by one
+ */
+void list_sort_parallel(SL_List *list, int threads)
+{
+	list->head = sort_parallel(list->head, list->length, threads, &list->tail);
+}
+
+/*
+ * merge_sorted - merges a sorted list into another
+ * @list: a sorted list, it gets the nodes of both
+ * @other: a sorted list, it is left empty with an empty pool
+ * Description: the nodes of other stay where they are, so list takes over
+ * its slabs and free nodes too, the slab other was carving is not carved
+ * any further but is freed with the rest by list_destroy
+ */
+void merge_sorted(SL_List *list, SL_List *other)
+{
+	if (list == other)
+		return;
+	list->head = merge_runs(list->head, other->head, &list->tail);
+	list->length += other->length;
+	NodePool *pool = &list->pool;
+	if (pool->slabs == NULL)
+	{
+		/*no slabs means no free nodes either, take the other pool as is*/
+		*pool = other->pool;
+	}
+	else if (other->pool.slabs != NULL)
+	{
+		NodeSlab *oldest = pool->slabs;
+		while (oldest->next != NULL)
+			oldest = oldest->next;
+		oldest->next = other->pool.slabs;
+		ListNode *free_nodes = other->pool.free_nodes;
+		if (free_nodes != NULL)
+		{
+			while (free_nodes->next != NULL)
+				free_nodes = free_nodes->next;
+			free_nodes->next = pool->free_nodes;
+			pool->free_nodes = other->pool.free_nodes;
+		}
+	}
+	other->pool.slabs = NULL;
+	other->pool.slab_used = 0;
+	other->pool.free_nodes = NULL;
+	reset_list(other);
+}
+
+/*
+ * dedupe_sorted - removes the repeated values of a sorted list
+ * @list: the list
+ * Return: number of nodes removed
+ * Description: the first node of each value is kept, the others go back to the pool
+ */
+int dedupe_sorted(SL_List *list)
+{
+	int removed = 0;
+	ListNode *current = list->head;
+	while (current != NULL && current->next != NULL)
+	{
+		ListNode *next = current->next;
+		if (next->value == current->value)
+		{
+			current->next = next->next;
+			free_node(list, next);
+			removed++;
+		}
+		else
+			current = next;
+	}
+	list->tail = current;
+	list->length -= removed;
+	return (removed);
+}
+
 int main()
 {
 	printf("Singly Linked List flavor 2\n");
-	SL_List *list = malloc(sizeof(SL_List));
+	SL_List *list = calloc(1, sizeof(SL_List));
 	if (list == NULL)
 	{
 		printf("Cannot create list\n");
@@ -322,13 +807,13 @@ int main()
 	push(list, 70);
 	push(list, 80);
 
-	pop(list);
+	pop(list, NULL);
 
 	unshift(list, 5);
 	unshift(list, 3);
 
-	shift(list);
-	shift(list);
+	shift(list, NULL);
+	shift(list, NULL);
 
 	update_node(list, 2, 25);
 
@@ -338,9 +823,9 @@ int main()
 	insert_middle(list, 3, 35);
 	insert_middle(list, 0, 5);
 
-	remove_from_middle(list, 0);
-	remove_from_middle(list, 7);
-	remove_from_middle(list, 2);
+	remove_from_middle(list, 0, NULL);
+	remove_from_middle(list, 7, NULL);
+	remove_from_middle(list, 2, NULL);
 	traverse(list);
 
 
@@ -348,5 +833,39 @@ int main()
 	printf("First Node: %d\n", list->head->value);
 	printf("Last Node: %d\n", list->tail->value);
 	printf("Length of the list: %d\n", list->length);
+
+	/*One pass with a cursor, drop the multiples of 10 and follow the rest with a copy*/
+	SL_Cursor cursor;
+	ListNode *current = sl_cursor_begin(&cursor, list);
+	while (current != NULL)
+	{
+		if (current->value % 10 == 0)
+		{
+			sl_cursor_remove(&cursor, NULL);
+			current = cursor.current;
+			continue;
+		}
+		sl_cursor_insert_after(&cursor, current->value);
+		sl_cursor_next(&cursor);
+		current = sl_cursor_next(&cursor);
+	}
+	traverse(list);
+	printf("Last Node: %d, Length of the list: %d\n", list->tail->value, list->length);
+	list_destroy(list);
+
+	/*sort two lists, one on several threads, then merge them and drop repeats*/
+	/*300000 nodes in evens, enough for 4 threads of PARALLEL_MIN_SORT nodes each*/
+	SL_List odds = {0};
+	SL_List evens = {0};
+	for (int i = 0; i < 600000; i++)
+		push(i % 2 ? &odds : &evens, (int)((i * 2654435761u) % 1000));
+	list_sort(&odds);
+	list_sort_parallel(&evens, 4);
+	merge_sorted(&odds, &evens);
+	int removed = dedupe_sorted(&odds);
+	printf("Sorted and merged: %d values left, %d repeats removed, first %d last %d\n",
+	       odds.length, removed, odds.head->value, odds.tail->value);
+	list_destroy(&odds);
+	free(list);
 	return (0);
 }
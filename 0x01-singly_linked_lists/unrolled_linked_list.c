@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+/*
+ * Unrolled flavor of the singly linked list of singly_linked_list_2.c
+ * Every node holds a whole array of values instead of one, sized so that a node
+ * is exactly one cache line. A scan reads 13 values per cache miss instead of one,
+ * and a value costs about 5 to 10 bytes instead of a 16 byte node plus the
+ * bookkeeping malloc keeps for it.
+ * The operations are the ones of SL_List, by index, nodes are split when a value
+ * has to go into a full one and merged with their neighbour when a removal
+ * leaves them less than half full.
+ */
+
+/* number of values in a node, a node is then 8 + 4 + 13 * 4 = 64 bytes */
+#define CHUNK_VALUES 13
+
+/*
+ * ChunkNode - structure of a single node in the list
+ * @next: a pointer to the next node
+ * @count: number of values in use, values[0] to values[count - 1]
+ * @values: the values held by that node, in list order
+ */
+typedef struct ChunkNode {
+	struct ChunkNode *next;
+	int count;
+	int values[CHUNK_VALUES];
+} __attribute__((aligned(64))) ChunkNode;
+
+/*
+ * UnrolledList - structure of an unrolled linked list
+ * @head: first node in the list
+ * @tail: last node in the list
+ * @length: number of values in the list
+ * @chunks: number of nodes in the list
+ */
+typedef struct UnrolledList {
+	ChunkNode *head;
+	ChunkNode *tail;
+	int length;
+	int chunks;
+} UL_List;
+
+/*
+ * INITIALIZE_NODE - reusable function to initialize an empty node
+ * @list: the list the node is for, it counts its nodes
+ * Return: the initialized node or null on failure
+ */
+ChunkNode *INITIALIZE_NODE(UL_List *list)
+{
+	ChunkNode *new_node = aligned_alloc(64, sizeof(ChunkNode));
+	if (new_node == NULL)
+		return (NULL);
+	new_node->next = NULL;
+	new_node->count = 0;
+	list->chunks++;
+	return (new_node);
+}
+
+/*
+ * free_node - frees a node that is no longer in the list
+ * @list: the list the node was in
+ * @node: the node
+ */
+void free_node(UL_List *list, ChunkNode *node)
+{
+	free(node);
+	list->chunks--;
+}
+
+/*
+ * reset_list - resets a lists back to its defaults
+ * @list: the list to be reset
+ * Description: resets the head and tail to NULL and length to 0*/
+void reset_list(UL_List *list)
+{
+	list->head = NULL;
+	list->tail = NULL;
+	list->length = 0;
+	list->chunks = 0;
+}
+
+/*
+ * list_destroy - frees every node of a list and resets it
+ * @list: the list
+ */
+void list_destroy(UL_List *list)
+{
+	ChunkNode *current = list->head;
+	while (current != NULL)
+	{
+		ChunkNode *next = current->next;
+		free(current);
+		current = next;
+	}
+	reset_list(list);
+}
+
+/*
+ * push - adds a new value to the end of a given list
+ * @list: the list to which we are adding the new value
+ * @new_node_value: the value we are adding to the list
+ * Return: 1 on success or 0 on failure
+ * Description: only takes a new node when the last one is full,
+ * so values pushed one after the other fill their nodes completely
+ */
+int push(UL_List *list, int new_node_value)
+{
+	if (list->tail == NULL || list->tail->count == CHUNK_VALUES)
+	{
+		ChunkNode *new_node = INITIALIZE_NODE(list);
+		if (new_node == NULL)
+			return (0);
+		if (list->tail == NULL)
+			list->head = new_node;
+		else
+			list->tail->next = new_node;
+		list->tail = new_node;
+	}
+	list->tail->values[list->tail->count++] = new_node_value;
+	list->length++;
+	return (1);
+}
+
+/*
+ * pop - removes the last value of a list
+ * @list: the list from which the last value is being removed
+ * @value: if not NULL, gets the removed value
+ * Return: 1 on success or 0 if the list is empty
+ * Description: the last node is only unlinked when it empties,
+ * which means walking to the node before it, once every CHUNK_VALUES pops
+ */
+int pop(UL_List *list, int *value)
+{
+	if (list->length == 0)
+		return (0);
+	list->tail->count--;
+	if (value != NULL)
+		*value = list->tail->values[list->tail->count];
+	list->length--;
+	if (list->tail->count > 0)
+		return (1);
+	if (list->head == list->tail)
+	{
+		free_node(list, list->tail);
+		reset_list(list);
+		return (1);
+	}
+	ChunkNode *node_before = list->head;
+	while (node_before->next != list->tail)
+		node_before = node_before->next;
+	free_node(list, list->tail);
+	node_before->next = NULL;
+	list->tail = node_before;
+	return (1);
+}
+
+/*
+ * unshift - adds a new value to the start of the list
+ * @list: the list to which the new value is being added
+ * @new_node_value: the value to be added
+ * Return: 1 on success or 0 on failure
+ */
+int unshift(UL_List *list, int new_node_value)
+{
+	if (list->head == NULL || list->head->count == CHUNK_VALUES)
+	{
+		ChunkNode *new_node = INITIALIZE_NODE(list);
+		if (new_node == NULL)
+			return (0);
+		new_node->next = list->head;
+		list->head = new_node;
+		if (list->tail == NULL)
+			list->tail = new_node;
+	}
+	ChunkNode *head = list->head;
+	memmove(&head->values[1], &head->values[0], head->count * sizeof(int));
+	head->values[0] = new_node_value;
+	head->count++;
+	list->length++;
+	return (1);
+}
+
+/*
+ * shift - removes the first value of a list
+ * @list: the list from which the first value is being removed
+ * @value: if not NULL, gets the removed value
+ * Return: 1 on success or 0 if the list is empty
+ */
+int shift(UL_List *list, int *value)
+{
+	if (list->length == 0)
+		return (0);
+	ChunkNode *head = list->head;
+	if (value != NULL)
+		*value = head->values[0];
+	head->count--;
+	memmove(&head->values[0], &head->values[1], head->count * sizeof(int));
+	list->length--;
+	if (head->count == 0)
+	{
+		list->head = head->next;
+		if (list->head == NULL)
+			list->tail = NULL;
+		free_node(list, head);
+	}
+	return (1);
+}
+
+/*
+ * find_chunk - finds the node holding the value at an index
+ * @list: the list, index must be within range
+ * @index: the index of the value
+ * @offset: gets the position of the value within the node
+ * @node_before: if not NULL, gets the node before the one returned, NULL for the head
+ * Return: the node
+ * Description: skips whole nodes by their count, one step per CHUNK_VALUES values
+ */
+ChunkNode *find_chunk(UL_List *list, int index, int *offset, ChunkNode **node_before)
+{
+	ChunkNode *previous = NULL;
+	ChunkNode *current = list->head;
+	while (index >= current->count)
+	{
+		index -= current->count;
+		previous = current;
+		current = current->next;
+	}
+	*offset = index;
+	if (node_before != NULL)
+		*node_before = previous;
+	return (current);
+}
+
+/*
+ * get_node - finds a value in the list
+ * @list: the list from which we are querying the value
+ * @index: the index of the value we want to get
+ * Return: a pointer to the value if it is there or NULL if it is not there
+ * Description: uses zero based indexing, first element has index 0
+ * and last element has index length_of_its_list - 1
+ */
+int *get_node(UL_List *list, int index)
+{
+	/*Check if the index is within ranges, return NULL if not*/
+	if (index < 0 || index >= list->length)
+		return (NULL);
+	/*The last value is found without walking the list*/
+	if (index == list->length - 1)
+		return (&list->tail->values[list->tail->count - 1]);
+	int offset;
+	ChunkNode *node = find_chunk(list, index, &offset, NULL);
+	return (&node->values[offset]);
+}
+
+/*
+ * update_node - updates a value of a list
+ * @list: the list in which the value is being updated
+ * @index: the index of the value in a list
+ * @new_node_value: the new value
+ * Return: a pointer to the updated value or NULL if index is out of range
+ */
+int *update_node(UL_List *list, int index, int new_node_value)
+{
+	int *value_to_update = get_node(list, index);
+	if (value_to_update == NULL)
+		return (NULL);
+	*value_to_update = new_node_value;
+	return (value_to_update);
+}
+
+/*
+ * insert_middle - inserts a value in the middle of a list
+ * @list: the list in which the value is to be inserted
+ * @index: the index to insert the value, as in singly_linked_list_2.c
+ * index 0 unshifts and index length - 1 pushes
+ * @node_value: the value to be inserted
+ * Return: 1 on success or 0 on failure
+ * Description: a full node is split in two halves first,
+ * so the values after the index only ever move within one node
+ */
+int insert_middle(UL_List *list, int index, int node_value)
+{
+	/*If the index is outside range, return 0*/
+	if (index < 0 || index >= list->length)
+		return (0);
+	if (index == 0)
+		return (unshift(list, node_value));
+	if (index == list->length - 1)
+		return (push(list, node_value));
+	int offset;
+	ChunkNode *node = find_chunk(list, index, &offset, NULL);
+	if (node->count == CHUNK_VALUES)
+	{
+		ChunkNode *new_node = INITIALIZE_NODE(list);
+		if (new_node == NULL)
+			return (0);
+		const int half = CHUNK_VALUES / 2;
+		new_node->count = CHUNK_VALUES - half;
+		memcpy(new_node->values, &node->values[half], new_node->count * sizeof(int));
+		node->count = half;
+		new_node->next = node->next;
+		node->next = new_node;
+		if (list->tail == node)
+			list->tail = new_node;
+		if (offset > half)
+		{
+			node = new_node;
+			offset -= half;
+		}
+	}
+	memmove(&node->values[offset + 1], &node->values[offset], (node->count - offset) * sizeof(int));
+	node->values[offset] = node_value;
+	node->count++;
+	list->length++;
+	return (1);
+}
+
+/*
+ * refill_node - tops up a node left less than half full by a removal
+ * @list: the list
+ * @node: the node, it is not the tail
+ * Description: if the next node fits in, it is merged into this one,
+ * otherwise values move over from it until both are at least half full
+ */
+void refill_node(UL_List *list, ChunkNode *node)
+{
+	ChunkNode *next = node->next;
+	if (node->count + next->count <= CHUNK_VALUES)
+	{
+		memcpy(&node->values[node->count], next->values, next->count * sizeof(int));
+		node->count += next->count;
+		node->next = next->next;
+		if (list->tail == next)
+			list->tail = node;
+		free_node(list, next);
+		return;
+	}
+	const int moved = (node->count + next->count) / 2 - node->count;
+	memcpy(&node->values[node->count], next->values, moved * sizeof(int));
+	node->count += moved;
+	next->count -= moved;
+	memmove(next->values, &next->values[moved], next->count * sizeof(int));
+}
+
+/*
+ * remove_from_middle - removes a value from the middle of a list
+ * @list: the list from which a value is being removed at the middle
+ * @index: the index of the value to be removed
+ * @value: if not NULL, gets the removed value
+ * Return: 1 on success or 0 if the index is out of range
+ */
+int remove_from_middle(UL_List *list, int index, int *value)
+{
+	/*validate the index*/
+	if (index < 0 || index >= list->length)
+		return (0);
+	if (index == 0)
+		return (shift(list, value));
+	if (index == list->length - 1)
+		return (pop(list, value));
+	int offset;
+	ChunkNode *node = find_chunk(list, index, &offset, NULL);
+	if (value != NULL)
+		*value = node->values[offset];
+	node->count--;
+	memmove(&node->values[offset], &node->values[offset + 1], (node->count - offset) * sizeof(int));
+	list->length--;
+	/*the index was not the last one, so the node is not the tail or still has values*/
+	if (node->count < CHUNK_VALUES / 2 && node->next != NULL)
+		refill_node(list, node);
+	return (1);
+}
+
+/*
+ * traverse - goes through the list printing each element
+ * @list: the list being traversed
+ * Return: 0 in case the list has no elements or 1 if the list has been successfully traversed*/
+int traverse(UL_List *list)
+{
+	if (list->length == 0)
+		return (0);
+	for (ChunkNode *current = list->head; current != NULL; current = current->next)
+		for (int i = 0; i < current->count; i++)
+			printf("%d -> ", current->values[i]);
+	printf("NULL\n");
+	return (1);
+}
+
+/*
+ * sum_list - adds up every value of a list
+ * @list: the list
+ * Return: the sum
+ * Description: the inner loop runs over a plain array and vectorizes
+ */
+long sum_list(UL_List *list)
+{
+	long sum = 0;
+	for (ChunkNode *current = list->head; current != NULL; current = current->next)
+		for (int i = 0; i < current->count; i++)
+			sum += current->values[i];
+	return (sum);
+}
+
+int main()
+{
+	printf("Unrolled Linked List\n");
+	UL_List list = {0};
+	int removed;
+	push(&list, 10);
+	push(&list, 20);
+	push(&list, 30);
+	push(&list, 40);
+	push(&list, 50);
+	push(&list, 60);
+	push(&list, 70);
+	push(&list, 80);
+
+	pop(&list, &removed);
+
+	unshift(&list, 5);
+	unshift(&list, 3);
+
+	shift(&list, &removed);
+	shift(&list, &removed);
+
+	update_node(&list, 2, 25);
+
+	printf("Node at idx 0 is: %d\n", *get_node(&list, 0));
+	printf("Node at idx 4 is: %d\n", *get_node(&list, 4));
+
+	insert_middle(&list, 3, 35);
+	insert_middle(&list, 0, 5);
+
+	remove_from_middle(&list, 0, &removed);
+	remove_from_middle(&list, 7, &removed);
+	remove_from_middle(&list, 2, &removed);
+	traverse(&list);
+
+	printf("==LIST INFO==\n");
+	printf("First Node: %d\n", *get_node(&list, 0));
+	printf("Last Node: %d\n", *get_node(&list, list.length - 1));
+	printf("Length of the list: %d\n", list.length);
+	list_destroy(&list);
+
+	/*a million values, then every other one of the first 2000 removed by index*/
+	for (int i = 0; i < 1000000; i++)
+		push(&list, i);
+	for (int i = 0; i < 1000; i++)
+		remove_from_middle(&list, i, &removed);
+	printf("%d values in %d nodes, %.1f bytes per value, sum %ld\n", list.length, list.chunks,
+	       (double)list.chunks * sizeof(ChunkNode) / list.length, sum_list(&list));
+	list_destroy(&list);
+	return (0);
+}
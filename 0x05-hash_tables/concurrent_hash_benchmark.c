@@ -0,0 +1,161 @@
+/*
+ * Scaling benchmark of the sharded hash table in concurrent_hash_tables.c
+ * Runs a read-mostly (95% search) and a write-heavy (50% search) mix on 1 to
+ * MAX_THREADS threads, against the same table with every call behind one
+ * global mutex as the baseline.
+ * Build and run with:
+ * gcc -O2 concurrent_hash_benchmark.c -o bench -pthread && ./bench [max threads]
+ */
+#define main concurrent_hash_tables_main
+#include "concurrent_hash_tables.c"
+#undef main
+
+#define NUM_KEYS 100000
+#define OPS_PER_THREAD 400000
+
+/*
+ * BenchArgs - what every benchmark thread gets
+ * @table: the shared table
+ * @keys: NUM_KEYS keys, every thread picks from all of them
+ * @search_percent: share of the operations that are searches, the rest are
+ * inserts and deletes in equal parts
+ * @global_lock: when not NULL, every call is made holding it
+ * @rng: per thread xorshift state
+ */
+typedef struct BenchArgs {
+    HashTable *table;
+    char (*keys)[16];
+    int search_percent;
+    pthread_mutex_t *global_lock;
+    uint64_t rng;
+} BenchArgs;
+
+/**
+ * now - reads a monotonic clock
+ * Return: the time in seconds
+*/
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * next_random - xorshift64 step
+ * @state: the generator state, never 0
+ * Return: the next random number
+*/
+static inline uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (*state);
+}
+
+/**
+ * bench_thread - runs OPS_PER_THREAD random operations on the table
+ * @arg: the BenchArgs of this thread
+ * Return: NULL
+*/
+static void *bench_thread(void *arg)
+{
+    BenchArgs *args = arg;
+    for (int op = 0; op < OPS_PER_THREAD; op++)
+    {
+        const uint64_t r = next_random(&args->rng);
+        const char *key = args->keys[(r >> 8) % NUM_KEYS];
+        const int kind = (int)(r % 100);
+        if (args->global_lock != NULL)
+            pthread_mutex_lock(args->global_lock);
+        if (kind < args->search_percent)
+        {
+            const int reader = read_lock(args->table);
+            search(args->table, key);
+            read_unlock(args->table, reader);
+        }
+        else if (kind & 1)
+            insert(args->table, key, key);
+        else
+            delete(args->table, key);
+        if (args->global_lock != NULL)
+            pthread_mutex_unlock(args->global_lock);
+    }
+    return (NULL);
+}
+
+/**
+ * run - times one mix on a given number of threads
+ * @keys: the keys to use
+ * @num_threads: how many threads to run
+ * @search_percent: share of searches in the mix
+ * @global_lock: NULL for the sharded table, or the mutex to wrap every call in
+ * Return: operations per second over all threads
+*/
+static double run(char (*keys)[16], int num_threads, int search_percent, pthread_mutex_t *global_lock)
+{
+    HashTable *table = INITIALIZE_HASHTABLE();
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    BenchArgs *args = malloc(num_threads * sizeof(BenchArgs));
+    if (table == NULL || threads == NULL || args == NULL)
+        exit(1);
+    // start from a table holding half of the keys
+    for (int i = 0; i < NUM_KEYS; i += 2)
+        insert(table, keys[i], keys[i]);
+    const double start = now();
+    for (int t = 0; t < num_threads; t++)
+    {
+        args[t] = (BenchArgs){table, keys, search_percent, global_lock, 0x9E3779B97F4A7C15ULL * (t + 1)};
+        pthread_create(&threads[t], NULL, bench_thread, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+        pthread_join(threads[t], NULL);
+    const double elapsed = now() - start;
+    delete_hash_table(table);
+    free(threads);
+    free(args);
+    return ((double)num_threads * OPS_PER_THREAD / elapsed);
+}
+
+/**
+ * print_row - times one mix on the sharded table and behind the global lock
+ * @keys: the keys to use
+ * @num_threads: how many threads to run
+ * @search_percent: share of searches in the mix
+ * @global_lock: the mutex of the baseline
+*/
+static void print_row(char (*keys)[16], int num_threads, int search_percent, pthread_mutex_t *global_lock)
+{
+    const double sharded = run(keys, num_threads, search_percent, NULL);
+    const double locked = run(keys, num_threads, search_percent, global_lock);
+    printf("%8d %16.0f %16.0f\n", num_threads, sharded, locked);
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 1)
+        max_threads = atoi(argv[1]);
+    if (max_threads < 1)
+        max_threads = 1;
+    char (*keys)[16] = malloc(NUM_KEYS * sizeof(*keys));
+    if (keys == NULL)
+        return (1);
+    for (int i = 0; i < NUM_KEYS; i++)
+        snprintf(keys[i], sizeof(keys[i]), "key-%d", i);
+    pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+    const int mixes[] = {95, 50};
+
+    printf("%d cpus online\n", (int)sysconf(_SC_NPROCESSORS_ONLN));
+    for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++)
+    {
+        printf("\n%d%% search:\n%8s %16s %16s\n", mixes[m], "threads", "sharded ops/s", "global lock ops/s");
+        // the powers of two below max_threads, then max_threads itself
+        for (int t = 1; t < max_threads; t *= 2)
+            print_row(keys, t, mixes[m], &global_lock);
+        print_row(keys, max_threads, mixes[m], &global_lock);
+    }
+    free(keys);
+    return (0);
+}
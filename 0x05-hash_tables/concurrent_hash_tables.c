@@ -0,0 +1,853 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+/*
+ * Thread safe flavor of the hash table
+ * The keyspace is split into NUM_SHARDS shards, picked by the high bits of the hash,
+ * each with its own lock, so writers to different shards never wait on each other.
+ * Readers take no lock at all, every shard carries a sequence counter (a seqlock)
+ * that writers make odd while they change the shard, readers retry if it was odd
+ * or changed under them.
+ * For readers to never touch freed memory, memory a reader can reach is freed by
+ * epochs: readers announce the epoch they started in (read_lock), memory
+ * unlinked by a writer is retired with the epoch of the moment and only freed
+ * once the epoch has moved on twice, which it can only do after every reader
+ * that might still see it has left. Items live in an arena per shard, which is
+ * compacted once replaced and deleted items fill half of it, so churn does not
+ * grow memory without bound.
+ */
+
+// must be a power of two
+#define SHARD_BITS 6
+#define NUM_SHARDS (1 << SHARD_BITS)
+#define INITIAL_SIZE 53
+// percentage of the slots (live items plus tombstones) at which a shard is resized
+#define MAX_LOAD 70
+// bytes of a regular arena slab, bigger items get a slab of their own
+#define SLAB_SIZE (64 * 1024)
+// readers that can be inside read_lock at the same time, more wait for a slot
+#define MAX_READERS 128
+
+/*
+ * HashTableItem - an item in a hashtable (also called a bucket)
+ * @key: the key of that item
+ * @value: the value under @key
+ * @hash: the full 64 bit hash of @key
+ * @key_len: length of @key
+ * @value_len: length of @value
+ * Description: items are never changed once a reader can see them,
+ * updating a key stores a new item and swaps the bucket over to it
+ */
+typedef struct HashTableItem {
+    char *key;
+    char *value;
+    uint64_t hash;
+    uint32_t key_len;
+    uint32_t value_len;
+}Ht_item;
+
+/*
+ * BucketArray - the buckets of a shard together with their number
+ * @size: number of buckets, a prime
+ * @next_retired: the array retired before this one, once it has been replaced
+ * @retired_epoch: the epoch it was retired in
+ * @items: the buckets
+ * Description: size and buckets are published as one pointer
+ * so a reader can never pair a size with the wrong array
+ */
+typedef struct BucketArray {
+    size_t size;
+    struct BucketArray *next_retired;
+    unsigned long retired_epoch;
+    Ht_item *items[];
+} BucketArray;
+
+/*
+ * ArenaSlab - a block of memory items are carved out of
+ * @next: the slab allocated before this one, or retired before it once retired
+ * @used: bytes of @data handed out so far
+ * @capacity: bytes in @data
+ * @retired_epoch: the epoch it was retired in, once its arena was compacted
+ * @data: the memory itself
+ */
+typedef struct ArenaSlab {
+    struct ArenaSlab *next;
+    size_t used;
+    size_t capacity;
+    unsigned long retired_epoch;
+    unsigned char data[];
+} ArenaSlab;
+
+/*
+ * Shard - an independently locked part of the hash table
+ * @lock: taken by insert and delete
+ * @seq: even when the shard is stable, odd while a writer is changing it
+ * @buckets: the current bucket array
+ * @count: number of live items
+ * @deleted: number of buckets holding the DELETED_ITEM sentinel
+ * @retired: bucket arrays replaced by resizes, newest first, waiting for readers to leave
+ * @slabs: the arena of the shard
+ * @retired_slabs: slabs of compacted arenas, newest first, waiting for readers to leave
+ * @arena_used: bytes of items in @slabs
+ * @arena_dead: bytes of @arena_used that belong to replaced or deleted items
+ * Description: shards are cache line aligned so that the locks
+ * and counters of two shards never share a line
+ */
+typedef struct Shard {
+    pthread_mutex_t lock;
+    unsigned int seq;
+    BucketArray *buckets;
+    size_t count;
+    size_t deleted;
+    BucketArray *retired;
+    ArenaSlab *slabs;
+    ArenaSlab *retired_slabs;
+    size_t arena_used;
+    size_t arena_dead;
+} __attribute__((aligned(64))) Shard;
+
+/*
+ * ReaderSlot - where a reader announces the epoch it started in
+ * @epoch: that epoch, or 0 when no reader holds the slot
+ * Description: one cache line per slot so readers never write to a shared line
+ */
+typedef struct ReaderSlot {
+    unsigned long epoch;
+} __attribute__((aligned(64))) ReaderSlot;
+
+/*
+ * HashTable - the sharded hash table
+ * @seed: random seed of the hash function
+ * @epoch: the current epoch, starts at 1 and only moves forward
+ * @readers: the slots of the readers inside read_lock
+ * @shards: the shards, shard i holds the keys whose hash starts with the bits of i
+ */
+typedef struct HashTable {
+    uint64_t seed;
+    unsigned long epoch __attribute__((aligned(64)));
+    ReaderSlot readers[MAX_READERS];
+    Shard shards[NUM_SHARDS];
+} HashTable;
+
+// for marking an item as deleted
+static Ht_item DELETED_ITEM = {NULL, NULL, 0, 0, 0};
+
+// odd 64 bit constants of the wyhash family, each one has half of its bits set
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+
+/**
+ * hash_mix - multiplies two 64 bit words into 128 bits and folds the halves together
+ * @a: first word
+ * @b: second word
+ * Return: the low half xor the high half of a * b
+*/
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    __uint128_t product = (__uint128_t)a * b;
+    return ((uint64_t)product ^ (uint64_t)(product >> 64));
+}
+
+/**
+ * read_word - reads 8 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_word(const unsigned char *p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return (word);
+}
+
+/**
+ * read_half - reads 4 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_half(const unsigned char *p)
+{
+    uint32_t half;
+    memcpy(&half, p, sizeof(half));
+    return (half);
+}
+
+/**
+ * hash - the hashing function (a wyhash style hash)
+ * @key_string: the key being hashed
+ * @len: the length of @key_string
+ * @seed: the seed of the table, different seeds give unrelated hashes
+ * Return: a 64 bit hash of @key_string
+ * Description: the key is consumed 16 bytes at a time, every 16 bytes cost one
+ * 64x64->128 bit multiply. The last 1 to 16 bytes are read with (possibly
+ * overlapping) word reads instead of a byte loop.
+*/
+static uint64_t hash(const char *key_string, size_t len, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char *)key_string;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            // first and last 4 bytes of each half, overlapping when len < 16
+            a = (read_half(p) << 32) | read_half(p + ((len >> 3) << 2));
+            b = (read_half(p + len - 4) << 32) | read_half(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+        }
+    } else {
+        size_t i = len;
+        while (i > 16)
+        {
+            seed = hash_mix(read_word(p) ^ HASH_P1, read_word(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read_word(p + i - 16);
+        b = read_word(p + i - 8);
+    }
+    return (hash_mix(HASH_P1 ^ len, hash_mix(a ^ HASH_P1, b ^ seed ^ HASH_P2)));
+}
+
+/**
+ * get_hash - method that tries to solve collision using double addressing
+ * @key_hash: the 64 bit hash of the string we are getting the bucket for
+ * @num_buckets: fancy name for the length of our hash table
+ * @attempt: number of collisions a string has run into
+ * Return: the hash
+ * Description: Double hashing makes use of two hash functions to 
+ * calculate the index an item should be stored at after i collisions.
+ * Both come out of the one 64 bit hash, the low half picks the first
+ * bucket and the high half picks the step.
+*/
+static size_t get_hash(uint64_t key_hash, const size_t num_buckets, const size_t attempt)
+{
+    const size_t hash_a = (size_t)(uint32_t)key_hash % num_buckets;
+    // the step has to stay in [1, num_buckets - 1], a step of num_buckets would
+    // probe the same bucket forever. Since the size is prime, every step visits every bucket
+    const size_t step = (size_t)(key_hash >> 32) % (num_buckets - 1) + 1;
+    return ((hash_a + (attempt % num_buckets) * step) % num_buckets);
+}
+
+/**
+ * is_prime - checks whether a number is prime
+ * @n: the number to check
+ * Return: 1 if @n is prime, 0 otherwise
+*/
+static int is_prime(size_t n)
+{
+    if (n < 2)
+        return (0);
+    for (size_t d = 2; d * d <= n; d++)
+    {
+        if (n % d == 0)
+            return (0);
+    }
+    return (1);
+}
+
+/**
+ * next_prime - finds the smallest prime that is greater than or equal to n
+ * @n: where to start looking from
+ * Return: the prime
+ * Description: double hashing needs a prime number of buckets
+ * so that every step size visits every bucket
+*/
+static size_t next_prime(size_t n)
+{
+    while (!is_prime(n))
+        n++;
+    return (n);
+}
+
+/**
+ * random_seed - gets a seed for the hash function of a new table
+ * Return: 64 random bits from the OS, or bits of the clock and the stack
+ * address if the OS has none to give
+*/
+static uint64_t random_seed(void)
+{
+    uint64_t seed;
+    if (getentropy(&seed, sizeof(seed)) == 0)
+        return (seed);
+    seed = (uint64_t)(uintptr_t)&seed;
+    return (seed ^ ((uint64_t)time(NULL) << 32));
+}
+
+/**
+ * new_bucket_array - allocates an empty bucket array
+ * @size: number of buckets, a prime
+ * Return: the array or NULL on failure
+*/
+static BucketArray *new_bucket_array(size_t size)
+{
+    BucketArray *buckets = calloc(1, sizeof(BucketArray) + size * sizeof(Ht_item *));
+    if (buckets == NULL)
+        return (NULL);
+    buckets->size = size;
+    return (buckets);
+}
+
+/**
+ * free_slabs - frees a list of arena slabs
+ * @slab: the first slab of the list
+*/
+static void free_slabs(ArenaSlab *slab)
+{
+    while (slab != NULL)
+    {
+        ArenaSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+}
+
+/**
+ * free_bucket_arrays - frees a list of retired bucket arrays
+ * @buckets: the first array of the list
+*/
+static void free_bucket_arrays(BucketArray *buckets)
+{
+    while (buckets != NULL)
+    {
+        BucketArray *next = buckets->next_retired;
+        free(buckets);
+        buckets = next;
+    }
+}
+
+/**
+ * free_shards - frees the memory of the first shards of a table
+ * @table: the table
+ * @count: number of shards whose lock and buckets were set up
+*/
+static void free_shards(HashTable *table, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Shard *shard = &table->shards[i];
+        pthread_mutex_destroy(&shard->lock);
+        free(shard->buckets);
+        free_bucket_arrays(shard->retired);
+        free_slabs(shard->slabs);
+        free_slabs(shard->retired_slabs);
+    }
+}
+
+/**
+ * delete_hash_table - deletes a hash table structure which frees the memory thus avoiding leaks
+ * @table: the table to be deleted, no other thread may be using it
+*/
+static void delete_hash_table(HashTable *table)
+{
+    free_shards(table, NUM_SHARDS);
+    free(table);
+}
+
+/*
+ * INITIALIZE_HASHTABLE - creates a new sharded hash table data structure
+ * Return: the created hash table or null on failure
+ */
+static HashTable *INITIALIZE_HASHTABLE()
+{
+    HashTable *new_hashtable = aligned_alloc(64, sizeof(HashTable));
+    if (new_hashtable == NULL)
+        return (NULL);
+    memset(new_hashtable, 0, sizeof(HashTable));
+    new_hashtable -> seed = random_seed();
+    new_hashtable -> epoch = 1;
+    for (int i = 0; i < NUM_SHARDS; i++)
+    {
+        Shard *shard = &new_hashtable->shards[i];
+        shard->buckets = new_bucket_array(INITIAL_SIZE);
+        if (shard->buckets == NULL || pthread_mutex_init(&shard->lock, NULL) != 0)
+        {
+            // only the shards before this one are fully set up
+            free(shard->buckets);
+            free_shards(new_hashtable, i);
+            free(new_hashtable);
+            return (NULL);
+        }
+    }
+    return (new_hashtable);
+}
+
+/**
+ * read_lock - enters a read section, memory reachable from the table is not
+ * freed before the matching read_unlock
+ * @table: the table
+ * Return: the reader slot to hand to read_unlock
+ * Description: a thread starts looking from the slot it used last, so it
+ * normally gets the same free slot back with one compare and swap
+*/
+int read_lock(HashTable *table)
+{
+    static int next_hint = 0;
+    static __thread int hint = -1;
+    if (hint < 0)
+        hint = __atomic_fetch_add(&next_hint, 1, __ATOMIC_RELAXED) % MAX_READERS;
+    for (int slot = hint;; slot = (slot + 1) % MAX_READERS)
+    {
+        unsigned long free_slot = 0;
+        const unsigned long epoch = __atomic_load_n(&table->epoch, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&table->readers[slot].epoch, &free_slot, epoch, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            // the slot has to be visible before anything the reader loads from the table
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            hint = slot;
+            return (slot);
+        }
+        if (slot == (hint + MAX_READERS - 1) % MAX_READERS)
+            sched_yield();
+    }
+}
+
+/**
+ * read_unlock - leaves a read section
+ * @table: the table
+ * @reader: the slot read_lock returned
+*/
+void read_unlock(HashTable *table, int reader)
+{
+    __atomic_store_n(&table->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * advance_epoch - moves the epoch on if every reader has seen the current one
+ * @table: the table
+ * Return: the epoch after the attempt
+ * Description: memory retired in epoch e was unlinked before the epoch moved
+ * to e + 1, so readers that start in e + 1 cannot reach it and once the epoch
+ * is e + 2 the readers of e have all left, it can be freed then
+*/
+static unsigned long advance_epoch(HashTable *table)
+{
+    unsigned long epoch = __atomic_load_n(&table->epoch, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+        const unsigned long reader = __atomic_load_n(&table->readers[i].epoch, __ATOMIC_ACQUIRE);
+        if (reader != 0 && reader != epoch)
+            return (epoch);
+    }
+    __atomic_compare_exchange_n(&table->epoch, &epoch, epoch + 1, 0,
+                                __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&table->epoch, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * reclaim - frees the retired memory of a shard that no reader can reach anymore
+ * @table: the table
+ * @shard: the shard, its lock must be held
+*/
+static void reclaim(HashTable *table, Shard *shard)
+{
+    const unsigned long epoch = advance_epoch(table);
+    // both lists are newest first, everything after the first old enough entry is too
+    BucketArray **buckets = &shard->retired;
+    while (*buckets != NULL && (*buckets)->retired_epoch + 2 > epoch)
+        buckets = &(*buckets)->next_retired;
+    free_bucket_arrays(*buckets);
+    *buckets = NULL;
+    ArenaSlab **slabs = &shard->retired_slabs;
+    while (*slabs != NULL && (*slabs)->retired_epoch + 2 > epoch)
+        slabs = &(*slabs)->next;
+    free_slabs(*slabs);
+    *slabs = NULL;
+}
+
+/**
+ * shard_of - picks the shard of a key
+ * @table: the table
+ * @key_hash: the hash of the key
+ * Return: the shard, chosen by the top SHARD_BITS bits of the hash
+ * (the low bits pick the bucket inside the shard)
+*/
+static inline Shard *shard_of(HashTable *table, uint64_t key_hash)
+{
+    return (&table->shards[key_hash >> (64 - SHARD_BITS)]);
+}
+
+/**
+ * item_bytes - arena space taken by an item
+ * @key_len: length of the key
+ * @value_len: length of the value
+ * Return: the bytes, rounded up to keep items 8 byte aligned
+*/
+static inline size_t item_bytes(size_t key_len, size_t value_len)
+{
+    return ((sizeof(Ht_item) + key_len + value_len + 2 + 7) & ~(size_t)7);
+}
+
+/**
+ * store_item - writes an item and its strings into the arena of a shard
+ * @shard: the shard owning the arena, its lock must be held
+ * @key: the key of the item
+ * @key_len: length of @key
+ * @value: the value of the item
+ * @key_hash: hash of @key
+ * Return: the stored item or NULL on failure
+*/
+static Ht_item *store_item(Shard *shard, const char *key, size_t key_len,
+                           const char *value, uint64_t key_hash)
+{
+    const size_t value_len = strlen(value);
+    if (key_len > UINT32_MAX || value_len > UINT32_MAX)
+        return (NULL);
+    const size_t bytes = item_bytes(key_len, value_len);
+    ArenaSlab *slab = shard->slabs;
+    if (slab == NULL || slab->capacity - slab->used < bytes)
+    {
+        const size_t capacity = bytes > SLAB_SIZE ? bytes : SLAB_SIZE;
+        slab = malloc(sizeof(ArenaSlab) + capacity);
+        if (slab == NULL)
+            return (NULL);
+        slab->used = 0;
+        slab->capacity = capacity;
+        slab->next = shard->slabs;
+        shard->slabs = slab;
+    }
+    Ht_item *new_item = (Ht_item *)(slab->data + slab->used);
+    slab->used += bytes;
+    shard->arena_used += bytes;
+    new_item -> key = (char *)(new_item + 1);
+    new_item -> value = new_item -> key + key_len + 1;
+    memcpy(new_item -> key, key, key_len + 1);
+    memcpy(new_item -> value, value, value_len + 1);
+    new_item -> hash = key_hash;
+    new_item -> key_len = (uint32_t)key_len;
+    new_item -> value_len = (uint32_t)value_len;
+    return (new_item);
+}
+
+/**
+ * find_index - finds the bucket holding key in a bucket array
+ * @buckets: the buckets to look in
+ * @key: the key we are looking for
+ * @key_hash: the hash of @key
+ * Return: the index of the bucket or -1 if the key is not in @buckets
+ * Description: safe to call without the lock, every bucket is read atomically
+ * and an item is fully written before a writer publishes it (release store)
+*/
+static long find_index(BucketArray *buckets, const char *key, uint64_t key_hash)
+{
+    const size_t size = buckets->size;
+    size_t index = get_hash(key_hash, size, 0);
+    Ht_item *item = __atomic_load_n(&buckets->items[index], __ATOMIC_ACQUIRE);
+    for (size_t i = 1; item != NULL && i <= size; i++){
+        if (item->hash == key_hash && item != &DELETED_ITEM && strcmp(item->key, key) == 0){
+            return ((long)index);
+        }
+        index = get_hash(key_hash, size, i);
+        item = __atomic_load_n(&buckets->items[index], __ATOMIC_ACQUIRE);
+    }
+    return (-1);
+}
+
+/**
+ * place_item - stores an item in the first free bucket of its probe sequence
+ * @buckets: the bucket array receiving the item
+ * Return: 1 if the item went into a bucket that held a tombstone, 0 otherwise
+*/
+static int place_item(BucketArray *buckets, Ht_item *item)
+{
+    size_t index = get_hash(item->hash, buckets->size, 0);
+    Ht_item *current_item = buckets->items[index];
+    size_t i = 1;
+    while (current_item != NULL && current_item != &DELETED_ITEM)
+    {
+        index = get_hash(item->hash, buckets->size, i);
+        current_item = buckets->items[index];
+        i++;
+    }
+    __atomic_store_n(&buckets->items[index], item, __ATOMIC_RELEASE);
+    return (current_item == &DELETED_ITEM);
+}
+
+/**
+ * write_begin - marks a shard as being changed, readers will retry
+ * @shard: the shard, its lock must be held
+*/
+static inline void write_begin(Shard *shard)
+{
+    __atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * write_end - marks a shard as stable again
+ * @shard: the shard, its lock must be held
+*/
+static inline void write_end(Shard *shard)
+{
+    __atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * rebuild_shard - rehashes a shard into a new bucket array, optionally copying
+ * its live items into a fresh arena
+ * @table: the table
+ * @shard: the shard, its lock must be held
+ * @new_size: number of buckets of the new array
+ * @compact: whether to copy the items, leaving replaced and deleted ones behind
+ * Return: 0 on success or -1 on failure, the shard is left as it was then
+ * Description: the new array is filled while readers keep using the old one and
+ * is then published with a single pointer store. The old array, and the old
+ * arena when compacting, are retired since a reader may still be probing them.
+*/
+static int rebuild_shard(HashTable *table, Shard *shard, size_t new_size, int compact)
+{
+    BucketArray *old = shard->buckets;
+    ArenaSlab *old_slabs = shard->slabs;
+    const size_t old_used = shard->arena_used;
+    BucketArray *buckets = new_bucket_array(new_size);
+    if (buckets == NULL)
+        return (-1);
+    if (compact)
+    {
+        shard->slabs = NULL;
+        shard->arena_used = 0;
+    }
+    for (size_t i = 0; i < old->size; i++)
+    {
+        Ht_item *item = old->items[i];
+        if (item == NULL || item == &DELETED_ITEM)
+            continue;
+        if (compact)
+        {
+            item = store_item(shard, item->key, item->key_len, item->value, item->hash);
+            if (item == NULL)
+            {
+                free_slabs(shard->slabs);
+                shard->slabs = old_slabs;
+                shard->arena_used = old_used;
+                free(buckets);
+                return (-1);
+            }
+        }
+        place_item(buckets, item);
+    }
+    write_begin(shard);
+    __atomic_store_n(&shard->buckets, buckets, __ATOMIC_RELEASE);
+    shard->deleted = 0;
+    write_end(shard);
+    const unsigned long epoch = __atomic_load_n(&table->epoch, __ATOMIC_ACQUIRE);
+    old->retired_epoch = epoch;
+    old->next_retired = shard->retired;
+    shard->retired = old;
+    if (compact && old_slabs != NULL)
+    {
+        shard->arena_dead = 0;
+        ArenaSlab *last = old_slabs;
+        for (;; last = last->next)
+        {
+            last->retired_epoch = epoch;
+            if (last->next == NULL)
+                break;
+        }
+        last->next = shard->retired_slabs;
+        shard->retired_slabs = old_slabs;
+    }
+    reclaim(table, shard);
+    return (0);
+}
+
+/**
+ * maintain_shard - rehashes a shard when the next insert would push its load
+ * factor over MAX_LOAD, and compacts its arena once half of it is dead items
+ * @table: the table
+ * @shard: the shard, its lock must be held
+ * Return: 0 on success or -1 on failure
+*/
+static int maintain_shard(HashTable *table, Shard *shard)
+{
+    const size_t size = shard->buckets->size;
+    const int compact = shard->arena_dead >= SLAB_SIZE && shard->arena_dead * 2 >= shard->arena_used;
+    const int full = (shard->count + shard->deleted + 1) * 100 > size * MAX_LOAD;
+    if (!compact && !full)
+        return (0);
+    size_t new_size = size;
+    // mostly tombstones, rehashing into the same size clears them
+    if (full && (shard->count + 1) * 100 > size * (MAX_LOAD / 2))
+        new_size = next_prime(size * 2);
+    return (rebuild_shard(table, shard, new_size, compact));
+}
+
+/**
+ * insert - inserts a key and a value (a bucket) to a given hash table
+ * @table: the table to which we are inserting the key value pair
+ * @key: the key of a bucket
+ * @value: value associated to a certain bucket
+ * Description: if @key is already present its value is replaced.
+ * Only the shard of @key is locked.
+*/
+void insert(HashTable *table, const char *key, const char *value)
+{
+    const size_t key_len = strlen(key);
+    const uint64_t key_hash = hash(key, key_len, table->seed);
+    Shard *shard = shard_of(table, key_hash);
+    pthread_mutex_lock(&shard->lock);
+    Ht_item *new_item = NULL;
+    if (maintain_shard(table, shard) == 0)
+        new_item = store_item(shard, key, key_len, value, key_hash);
+    if (new_item == NULL)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+    BucketArray *buckets = shard->buckets;
+    long index = find_index(buckets, key, key_hash);
+    write_begin(shard);
+    if (index >= 0)
+    {
+        // the old item stays in the arena until the next compaction, a reader may be holding its value
+        Ht_item *old_item = buckets->items[index];
+        __atomic_store_n(&buckets->items[index], new_item, __ATOMIC_RELEASE);
+        shard->arena_dead += item_bytes(old_item->key_len, old_item->value_len);
+    } else {
+        shard->deleted -= place_item(buckets, new_item);
+        shard->count++;
+    }
+    write_end(shard);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * search - tries to locate a value given a key, without taking any lock
+ * @table: the table from which we try to locate the value
+ * @key: the key to use for searching
+ * Return: the found value associated with key or NULL if no item is found
+ * Description: the probe is retried if a writer changed the shard while it ran.
+ * Must be called between read_lock and read_unlock, the returned string stays
+ * valid until read_unlock, even if the key is deleted or updated in the meantime.
+*/
+char *search(HashTable *table, const char *key)
+{
+    const uint64_t key_hash = hash(key, strlen(key), table->seed);
+    Shard *shard = shard_of(table, key_hash);
+    for (;;)
+    {
+        const unsigned int seq = __atomic_load_n(&shard->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+        {
+            sched_yield();
+            continue;
+        }
+        BucketArray *buckets = __atomic_load_n(&shard->buckets, __ATOMIC_ACQUIRE);
+        long index = find_index(buckets, key, key_hash);
+        char *value = NULL;
+        if (index >= 0)
+        {
+            Ht_item *item = __atomic_load_n(&buckets->items[index], __ATOMIC_ACQUIRE);
+            if (item != NULL && item != &DELETED_ITEM)
+                value = item->value;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shard->seq, __ATOMIC_RELAXED) == seq)
+            return (value);
+    }
+}
+
+/**
+ * delete - deletes an item from a hash table
+ * @table: the table from which we are deleting from
+ * @key: the key of the bucket to delete
+ * Description: the item is replaced by the DELETED_ITEM sentinel,
+ * its memory is given back by the next compaction of the shard
+*/
+void delete(HashTable *table, const char *key)
+{
+    const uint64_t key_hash = hash(key, strlen(key), table->seed);
+    Shard *shard = shard_of(table, key_hash);
+    pthread_mutex_lock(&shard->lock);
+    long index = find_index(shard->buckets, key, key_hash);
+    if (index >= 0)
+    {
+        Ht_item *old_item = shard->buckets->items[index];
+        write_begin(shard);
+        __atomic_store_n(&shard->buckets->items[index], &DELETED_ITEM, __ATOMIC_RELEASE);
+        shard->count--;
+        shard->deleted++;
+        write_end(shard);
+        shard->arena_dead += item_bytes(old_item->key_len, old_item->value_len);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * count_items - counts the live items of every shard
+ * @table: the table
+ * Return: the number of items, only exact if no writer is running
+*/
+static size_t count_items(HashTable *table)
+{
+    size_t count = 0;
+    for (int i = 0; i < NUM_SHARDS; i++)
+        count += __atomic_load_n(&table->shards[i].count, __ATOMIC_RELAXED);
+    return (count);
+}
+
+#define DEMO_THREADS 4
+#define DEMO_KEYS 20000
+
+/**
+ * demo_writer - inserts and deletes its own slice of keys
+ * @arg: the table
+ * Return: NULL
+*/
+static void *demo_writer(void *arg)
+{
+    static int next_id = 0;
+    HashTable *table = arg;
+    const int id = __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED);
+    char key[32];
+    for (int i = id; i < DEMO_KEYS; i += DEMO_THREADS)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        insert(table, key, key);
+    }
+    for (int i = id; i < DEMO_KEYS; i += 2 * DEMO_THREADS)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        delete(table, key);
+    }
+    return (NULL);
+}
+
+int main()
+{
+    printf("Sharded hash tables\n");
+    HashTable *table = INITIALIZE_HASHTABLE();
+    if (table == NULL)
+        return (1);
+    insert(table, "cat", "meows");
+    insert(table, "tac", "weoms");
+    insert(table, "dog", "barks");
+    int reader = read_lock(table);
+    printf("A cat %s\n", search(table, "cat"));
+    printf("A tac %s\n", search(table, "tac"));
+    printf("A dog %s\n", search(table, "dog"));
+    read_unlock(table, reader);
+
+    pthread_t threads[DEMO_THREADS];
+    for (int i = 0; i < DEMO_THREADS; i++)
+        pthread_create(&threads[i], NULL, demo_writer, table);
+    for (int i = 0; i < DEMO_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    reader = read_lock(table);
+    printf("key-4245 %s\n", search(table, "key-4245"));
+    printf("key-4241 %s\n", search(table, "key-4241"));
+    read_unlock(table, reader);
+    printf("count: %zu\n", count_items(table));
+    delete_hash_table(table);
+    return (0);
+}
@@ -0,0 +1,99 @@
+/*
+ * Microbenchmark of the hash function of hash_tables.c against the pow()
+ * based hash it replaced, in keys hashed per second for a few key lengths
+ * Build and run with:
+ * gcc -O2 hash_benchmark.c -o bench -lm && ./bench
+ */
+#include <math.h>
+#include <time.h>
+
+// reuse the real hash table code, without its demo main
+#define main hash_tables_main
+#include "hash_tables.c"
+#undef main
+
+#define NUM_KEYS 4096
+#define ROUNDS 200
+
+/**
+ * pow_hash - the original hashing function, kept here as the baseline
+ * @key_string: the string being hashed
+ * @a: a prime number larger than the size of the alphabet
+ * @m: the size of the hash table
+ * Return: the bucket index of @key_string
+*/
+static int pow_hash(const char *key_string, const int a, const int m)
+{
+    long hash = 0;
+    const int len_s = strlen(key_string);
+    for (int i = 0; i < len_s; i++) {
+        hash += (long)pow(a, len_s - (i+1)) * key_string[i];
+        hash = hash % m;
+    }
+    return (int)hash;
+}
+
+/**
+ * now - reads a monotonic clock
+ * Return: the time in seconds
+*/
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * make_keys - fills keys with NUM_KEYS random printable strings
+ * @keys: where the keys go, NUM_KEYS rows of @len + 1 bytes
+ * @len: the length of every key
+*/
+static void make_keys(char *keys, size_t len)
+{
+    for (size_t k = 0; k < NUM_KEYS; k++)
+    {
+        char *key = keys + k * (len + 1);
+        for (size_t i = 0; i < len; i++)
+            key[i] = 'a' + rand() % 26;
+        key[len] = '\0';
+    }
+}
+
+int main()
+{
+    const size_t lengths[] = {4, 8, 16, 32, 64, 128};
+    // sink keeps the compiler from throwing the hashing away
+    volatile uint64_t sink = 0;
+    const uint64_t seed = random_seed();
+
+    printf("%8s %16s %16s %8s\n", "key len", "pow keys/s", "wyhash keys/s", "speedup");
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+        const size_t len = lengths[l];
+        char *keys = malloc(NUM_KEYS * (len + 1));
+        if (keys == NULL)
+            return (1);
+        make_keys(keys, len);
+
+        double start = now();
+        for (int r = 0; r < ROUNDS; r++)
+            for (size_t k = 0; k < NUM_KEYS; k++)
+                sink += pow_hash(keys + k * (len + 1), 151, 53);
+        const double pow_rate = (double)NUM_KEYS * ROUNDS / (now() - start);
+
+        start = now();
+        for (int r = 0; r < ROUNDS; r++)
+            for (size_t k = 0; k < NUM_KEYS; k++)
+            {
+                const char *key = keys + k * (len + 1);
+                // strlen is part of the cost, insert and search pay it too
+                sink += hash(key, strlen(key), seed);
+            }
+        const double new_rate = (double)NUM_KEYS * ROUNDS / (now() - start);
+
+        printf("%8zu %16.0f %16.0f %7.1fx\n", len, pow_rate, new_rate, new_rate / pow_rate);
+        free(keys);
+    }
+    return (0);
+}
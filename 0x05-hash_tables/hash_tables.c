@@ -1,41 +1,237 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
-#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INITIAL_SIZE 53
+// percentage of the slots (live items plus tombstones) at which the table is resized
+#define MAX_LOAD 70
+// percentage of live items under which the table shrinks
+#define MIN_LOAD 10
+// number of old buckets moved to the new array by every insert, search and delete
+#define MIGRATE_STEP 8
+// bytes of a regular arena slab, bigger items get a slab of their own
+#define SLAB_SIZE (64 * 1024)
+// number of keys search_batch and insert_batch keep in flight at once
+#define BATCH_GROUP 16
+// probe lengths 0 to PROBE_HISTOGRAM_SIZE - 2 get a histogram bucket each, the last bucket is everything longer
+#define PROBE_HISTOGRAM_SIZE 16
 /*
  * HashTableItem - an item in a hashtable (also called a bucket)
  * @key: the key of that item
  * @value: the value under @key
+ * @hash: the full 64 bit hash of @key, kept so that probing and resizing never
+ * rehash a key and so that most non matching keys are told apart without a strcmp
+ * @key_len: length of @key
+ * @value_len: length of @value
+ * Description: items live in the arena of their table, the key and the value
+ * are stored right behind the item itself so one insert is one arena allocation
  */
 typedef struct HashTableItem {
     char *key;
     char *value;
+    uint64_t hash;
+    uint32_t key_len;
+    uint32_t value_len;
 }Ht_item;
 
+/*
+ * ArenaSlab - a block of memory items are carved out of
+ * @next: the slab allocated before this one
+ * @used: bytes of @data handed out so far
+ * @capacity: bytes in @data
+ * @data: the memory itself
+ */
+typedef struct ArenaSlab {
+    struct ArenaSlab *next;
+    size_t used;
+    size_t capacity;
+    unsigned char data[];
+} ArenaSlab;
+
+/*
+ * ProbeKind - what a probe length histogram counts
+ * @PROBE_HIT: lookups that found their key
+ * @PROBE_MISS: lookups that did not
+ * @PROBE_INSERT: inserts, the collisions before a free bucket
+ * @PROBE_DELETE: deletes, found or not
+ * @PROBE_KINDS: number of histograms
+ */
+enum ProbeKind {
+    PROBE_HIT,
+    PROBE_MISS,
+    PROBE_INSERT,
+    PROBE_DELETE,
+    PROBE_KINDS
+};
+
+/*
+ * ThreadStats - the probe counters one thread keeps for one table
+ * @next: the block of another thread
+ * @owner: identifies the thread owning the block, the address of a thread local
+ * @probes: a probe length histogram per ProbeKind
+ * Description: only the owning thread writes a block, so counting is a plain
+ * increment with no atomic read-modify-write and no shared cache line.
+ * hash_table_stats_dump adds the blocks of every thread up when it runs.
+ */
+typedef struct ThreadStats {
+    struct ThreadStats *next;
+    const void *owner;
+    uint64_t probes[PROBE_KINDS][PROBE_HISTOGRAM_SIZE];
+} ThreadStats;
+
 /*
  * HashTable - our hash table data structure
  * @size: the size of the hash table
- * @count: how full the hash table is
+ * @count: how full the hash table is (items in both @items and @old_items)
+ * @deleted: number of slots of @items holding the DELETED_ITEM sentinel
  * @items: an array of pointers to hash table items
+ * @old_size: the size of @old_items
+ * @migrate_index: the next bucket of @old_items to move over to @items
+ * @old_items: the array we are rehashing away from, NULL when no resize is going on
+ * @seed: random per table seed of the hash function, so that nobody can craft
+ * a set of keys that all collide without knowing it
+ * @slabs: the arena holding every item, keys and values included, newest slab first
+ * @arena_used: bytes handed out from @slabs
+ * @arena_dead: bytes of @arena_used that belong to deleted items, compact_hash_table gives them back
+ * @stats_enabled: whether inserts, lookups and deletes record their probe lengths, off by default
+ * @stats_id: tells this table apart from an earlier one that lived at the same address
+ * @stats: the probe counters, one block per thread that looked something up
+ * @resizes: number of resizes started
+ * Description: resizing is incremental, every insert, search and delete moves
+ * MIGRATE_STEP buckets from @old_items to @items so no single call pays for a full rehash.
+ * Until the migration is over, an item can live in either array.
  */
 typedef struct HashTable {
     size_t size;
     size_t count;
+    size_t deleted;
     Ht_item **items;
+    size_t old_size;
+    size_t migrate_index;
+    Ht_item **old_items;
+    uint64_t seed;
+    ArenaSlab *slabs;
+    size_t arena_used;
+    size_t arena_dead;
+    int stats_enabled;
+    uint64_t stats_id;
+    ThreadStats *stats;
+    size_t resizes;
 } HashTable;
 
-static Ht_item *INITIALIZE_HASH_TABLE_ITEM(const char *key, const char *value)
+/**
+ * item_bytes - number of arena bytes taken by an item
+ * @key_len: length of the key
+ * @value_len: length of the value
+ * Return: the size of the item plus both strings and their terminators,
+ * rounded up so that the next item stays 8 byte aligned
+*/
+static size_t item_bytes(size_t key_len, size_t value_len)
+{
+    return ((sizeof(Ht_item) + key_len + value_len + 2 + 7) & ~(size_t)7);
+}
+
+/**
+ * arena_alloc - carves bytes out of the newest slab of a table, adding a slab when it is full
+ * @table: the table owning the arena
+ * @bytes: how many bytes are needed, a multiple of 8
+ * Return: the memory or NULL on failure
+*/
+static void *arena_alloc(HashTable *table, size_t bytes)
+{
+    ArenaSlab *slab = table->slabs;
+    if (slab == NULL || slab->capacity - slab->used < bytes)
+    {
+        const size_t capacity = bytes > SLAB_SIZE ? bytes : SLAB_SIZE;
+        slab = malloc(sizeof(ArenaSlab) + capacity);
+        if (slab == NULL)
+            return (NULL);
+        slab->used = 0;
+        slab->capacity = capacity;
+        slab->next = table->slabs;
+        table->slabs = slab;
+    }
+    void *memory = slab->data + slab->used;
+    slab->used += bytes;
+    table->arena_used += bytes;
+    return (memory);
+}
+
+/**
+ * free_slabs - frees a list of arena slabs
+ * @slab: the first slab of the list
+*/
+static void free_slabs(ArenaSlab *slab)
+{
+    while (slab != NULL)
+    {
+        ArenaSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+}
+
+/**
+ * store_item - writes an item and its strings into the arena of a table
+ * @table: the table owning the arena
+ * @key: the key of the item
+ * @key_len: length of @key
+ * @value: the value of the item
+ * @value_len: length of @value
+ * @key_hash: hash of @key
+ * Return: the stored item or NULL on failure
+*/
+static Ht_item *store_item(HashTable *table, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t key_hash)
 {
-    Ht_item *new_item = malloc(sizeof(Ht_item));
+    Ht_item *new_item = arena_alloc(table, item_bytes(key_len, value_len));
     if (new_item == NULL)
         return (NULL);
-    new_item -> key = strdup(key);
-    new_item -> value = strdup(value);
+    new_item -> key = (char *)(new_item + 1);
+    new_item -> value = new_item -> key + key_len + 1;
+    memcpy(new_item -> key, key, key_len + 1);
+    memcpy(new_item -> value, value, value_len + 1);
+    new_item -> hash = key_hash;
+    new_item -> key_len = (uint32_t)key_len;
+    new_item -> value_len = (uint32_t)value_len;
     return (new_item);
 }
 
+static Ht_item *INITIALIZE_HASH_TABLE_ITEM(HashTable *table, const char *key, const char *value, uint64_t key_hash)
+{
+    const size_t key_len = strlen(key);
+    const size_t value_len = strlen(value);
+    // lengths are stored in 32 bits
+    if (key_len > UINT32_MAX || value_len > UINT32_MAX)
+        return (NULL);
+    return (store_item(table, key, key_len, value, value_len, key_hash));
+}
+
 // for marking an item as deleted
-static Ht_item DELETED_ITEM = {NULL, NULL};
+static Ht_item DELETED_ITEM = {NULL, NULL, 0, 0, 0};
+
+/**
+ * random_seed - gets a seed for the hash function of a new table
+ * Return: 64 random bits from the OS, or bits of the clock and the stack
+ * address if the OS has none to give
+*/
+static uint64_t random_seed(void)
+{
+    uint64_t seed;
+    if (getentropy(&seed, sizeof(seed)) == 0)
+        return (seed);
+    seed = (uint64_t)(uintptr_t)&seed;
+    return (seed ^ ((uint64_t)time(NULL) << 32));
+}
+
+// hands out HashTable.stats_id
+static uint64_t next_stats_id = 0;
 
 /*
  * INITIALIZE_HASHTABLE - creates a new hash table data structure
@@ -46,111 +242,569 @@ static HashTable *INITIALIZE_HASHTABLE()
     HashTable *new_hashtable = malloc(sizeof(HashTable));
     if (new_hashtable == NULL)
         return (NULL);
-    new_hashtable -> size = 53;
+    new_hashtable -> size = INITIAL_SIZE;
     new_hashtable -> count = 0;
-    new_hashtable -> items = calloc((size_t) new_hashtable->size, sizeof(Ht_item));
+    new_hashtable -> deleted = 0;
+    new_hashtable -> items = calloc((size_t) new_hashtable->size, sizeof(Ht_item *));
+    new_hashtable -> old_size = 0;
+    new_hashtable -> migrate_index = 0;
+    new_hashtable -> old_items = NULL;
+    new_hashtable -> seed = random_seed();
+    new_hashtable -> slabs = NULL;
+    new_hashtable -> arena_used = 0;
+    new_hashtable -> arena_dead = 0;
+    new_hashtable -> stats_enabled = 0;
+    new_hashtable -> stats_id = __atomic_add_fetch(&next_stats_id, 1, __ATOMIC_RELAXED);
+    new_hashtable -> stats = NULL;
+    new_hashtable -> resizes = 0;
+    if (new_hashtable -> items == NULL)
+    {
+        free(new_hashtable);
+        return (NULL);
+    }
     return (new_hashtable);
 }
 
 /**
- * delte_ht_item - deletes a hash table item which frees the memory thus avoiding memory leaks
+ * delete_ht_item - deletes a hash table item
+ * @table: the table owning the item
  * @item: the item to be deleted
+ * Description: the item stays in the arena until the next compact_hash_table,
+ * we only keep count of the bytes it is wasting
 */
-static void delete_ht_item(Ht_item *item)
+static void delete_ht_item(HashTable *table, Ht_item *item)
 {
-    free(item -> key);
-    free(item -> value);
-    free(item);
+    table->arena_dead += item_bytes(item->key_len, item->value_len);
 }
 
 /**
  * delte_hash_table - deletes a hash table structure which frees the memory thus avoiding leaks
  * @table: the table to be deleted
+ * Description: items live in the arena, so this frees the slabs and the
+ * bucket arrays without visiting a single item
 */
 static void delete_hash_table(HashTable *table)
 {
-    for (int i = 0; i < table->size; i++)
+    while (table -> stats != NULL)
     {
-        Ht_item *current = table->items[i];
-        if (current != NULL){
-            delete_ht_item(current);
-        }
+        ThreadStats *next = table -> stats -> next;
+        free(table -> stats);
+        table -> stats = next;
     }
+    free_slabs(table -> slabs);
+    free(table -> old_items);
     free(table -> items);
     free(table);
 }
 
 /**
- * hash - the hashing function
- * @a: a prime number larger than the size of the alphabet
- * We're hashing ASCII strings, which has an alphabet size of 128, so we should choose a prime larger than that.
- * @m: some upper limit, preferably the size of our hash table
- * Return: an integer value which will represent the index of an item in the hash table
- * Description: the function takes in a string input and returns a number 
- * between 0 and m (m can be our desired hash table length or bucket array length)
+ * compact_bucket_array - copies the live items of an array of buckets into a new arena
+ * @table: the table, its arena is the one being filled
+ * @items: the buckets, pointers are updated to the copies
+ * @from: first bucket to look at
+ * @size: number of buckets in @items
+ * Return: 0 on success or -1 on failure
 */
-static int hash(const char *key_string, const int a, const int m)
+static int compact_bucket_array(HashTable *table, Ht_item **items, size_t from, size_t size)
 {
-    long hash = 0;
-    const int len_s = strlen(key_string);
-    for (int i = 0; i < len_s; i++) {
-        hash += (long)pow(a, len_s - (i+1)) * key_string[i];
-        hash = hash % m;
+    for (size_t i = from; i < size; i++)
+    {
+        Ht_item *item = items[i];
+        if (item == NULL || item == &DELETED_ITEM)
+            continue;
+        Ht_item *copy = store_item(table, item->key, item->key_len,
+                                   item->value, item->value_len, item->hash);
+        if (copy == NULL)
+            return (-1);
+        items[i] = copy;
     }
-    return (int)hash;
+    return (0);
+}
+
+/**
+ * compact_hash_table - gives back the arena space of deleted items
+ * @table: the table to compact
+ * Return: the number of bytes reclaimed, or 0 on failure (the table is left as it was)
+ * Description: every live item is copied into fresh slabs and the old slabs are freed.
+ * This touches every item, so it is never run behind the caller's back, run it
+ * when arena_dead gets large compared to arena_used and there is time to spare.
+ * The values live in the old slabs, so every pointer search returned before
+ * compaction dangles afterwards, copy out any value that has to outlive it
+*/
+static size_t compact_hash_table(HashTable *table)
+{
+    ArenaSlab *old_slabs = table->slabs;
+    const size_t old_used = table->arena_used;
+    const size_t old_dead = table->arena_dead;
+    // copy into pointer arrays first so a failure leaves the buckets untouched
+    Ht_item **items = malloc(table->size * sizeof(Ht_item *));
+    Ht_item **old_items = NULL;
+    if (items == NULL)
+        return (0);
+    memcpy(items, table->items, table->size * sizeof(Ht_item *));
+    if (table->old_items != NULL)
+    {
+        old_items = malloc(table->old_size * sizeof(Ht_item *));
+        if (old_items == NULL)
+        {
+            free(items);
+            return (0);
+        }
+        memcpy(old_items, table->old_items, table->old_size * sizeof(Ht_item *));
+    }
+    table->slabs = NULL;
+    table->arena_used = 0;
+    table->arena_dead = 0;
+    if (compact_bucket_array(table, items, 0, table->size) != 0 ||
+        (old_items != NULL && compact_bucket_array(table, old_items, table->migrate_index, table->old_size) != 0))
+    {
+        free_slabs(table->slabs);
+        free(items);
+        free(old_items);
+        table->slabs = old_slabs;
+        table->arena_used = old_used;
+        table->arena_dead = old_dead;
+        return (0);
+    }
+    free(table->items);
+    table->items = items;
+    if (old_items != NULL)
+    {
+        free(table->old_items);
+        table->old_items = old_items;
+    }
+    free_slabs(old_slabs);
+    return (old_used - table->arena_used);
+}
+
+// odd 64 bit constants of the wyhash family, each one has half of its bits set
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+
+/**
+ * hash_mix - multiplies two 64 bit words into 128 bits and folds the halves together
+ * @a: first word
+ * @b: second word
+ * Return: the low half xor the high half of a * b
+*/
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    __uint128_t product = (__uint128_t)a * b;
+    return ((uint64_t)product ^ (uint64_t)(product >> 64));
+}
+
+/**
+ * read_word - reads 8 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_word(const unsigned char *p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return (word);
+}
+
+/**
+ * read_half - reads 4 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_half(const unsigned char *p)
+{
+    uint32_t half;
+    memcpy(&half, p, sizeof(half));
+    return (half);
+}
+
+/**
+ * hash - the hashing function (a wyhash style hash)
+ * @key_string: the key being hashed
+ * @len: the length of @key_string
+ * @seed: the seed of the table, different seeds give unrelated hashes
+ * Return: a 64 bit hash of @key_string
+ * Description: the key is consumed 16 bytes at a time, every 16 bytes cost one
+ * 64x64->128 bit multiply. The last 1 to 16 bytes are read with (possibly
+ * overlapping) word reads instead of a byte loop.
+*/
+static uint64_t hash(const char *key_string, size_t len, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char *)key_string;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            // first and last 4 bytes of each half, overlapping when len < 16
+            a = (read_half(p) << 32) | read_half(p + ((len >> 3) << 2));
+            b = (read_half(p + len - 4) << 32) | read_half(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+        }
+    } else {
+        size_t i = len;
+        while (i > 16)
+        {
+            seed = hash_mix(read_word(p) ^ HASH_P1, read_word(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read_word(p + i - 16);
+        b = read_word(p + i - 8);
+    }
+    return (hash_mix(HASH_P1 ^ len, hash_mix(a ^ HASH_P1, b ^ seed ^ HASH_P2)));
 }
 
 /**
  * get_hash - method that tries to solve collision using double addressing
- * @key_string: the string we are getting hash value for
+ * @key_hash: the 64 bit hash of the string we are getting the bucket for
  * @num_buckets: fancy name for the length of our hash table
  * @attempt: number of collisions a string has run into
  * Return: the hash
  * Description: Double hashing makes use of two hash functions to 
  * calculate the index an item should be stored at after i collisions.
+ * Both come out of the one 64 bit hash, the low half picks the first
+ * bucket and the high half picks the step.
 */
-static int get_hash(const char* key_string, const int num_buckets, const int attempt)
+static size_t get_hash(uint64_t key_hash, const size_t num_buckets, const size_t attempt)
 {
-    const int hash_a = hash(key_string, 151, num_buckets);
-    const int hash_b = hash(key_string, 151, num_buckets);
-    return (hash_a + (attempt * (hash_b + 1))) % num_buckets;
+    const size_t hash_a = (size_t)(uint32_t)key_hash % num_buckets;
+    // the step has to stay in [1, num_buckets - 1], a step of num_buckets would
+    // probe the same bucket forever. Since the size is prime, every step visits every bucket
+    const size_t step = (size_t)(key_hash >> 32) % (num_buckets - 1) + 1;
+    return ((hash_a + (attempt % num_buckets) * step) % num_buckets);
 }
 
 /**
- * insert - inserts a key and a value (a bucket) to a given hash table
- * @table: the table to which we are inserting the key value pair
- * @key: the key of a bucket
- * @value: value associated to a certain bucket
+ * is_prime - checks whether a number is prime
+ * @n: the number to check
+ * Return: 1 if @n is prime, 0 otherwise
 */
-void insert(HashTable *table, const char *key, const char *value)
+static int is_prime(size_t n)
 {
-    // To insert a new key-value pair, we iterate through indexes until we find an empty bucket
-    // We then insert the item into that bucket and increment the hash table's count attribute
+    if (n < 2)
+        return (0);
+    for (size_t d = 2; d * d <= n; d++)
+    {
+        if (n % d == 0)
+            return (0);
+    }
+    return (1);
+}
 
-    // initialize the item
-    Ht_item *new_item = INITIALIZE_HASH_TABLE_ITEM(key, value);
-    int index = get_hash(new_item->key, table->size, 0);
+/**
+ * next_prime - finds the smallest prime that is greater than or equal to n
+ * @n: where to start looking from
+ * Return: the prime
+ * Description: double hashing needs a prime number of buckets
+ * so that every step size visits every bucket
+*/
+static size_t next_prime(size_t n)
+{
+    while (!is_prime(n))
+        n++;
+    return (n);
+}
+
+/**
+ * find_index - finds the bucket holding key in an array of buckets
+ * @items: the buckets to look in
+ * @size: number of buckets in @items
+ * @key: the key we are looking for
+ * @key_hash: the hash of @key
+ * @probes: gets the number of collisions the lookup ran into
+ * Return: the index of the bucket or -1 if the key is not in @items
+ * Description: the stored hashes are compared first, strcmp only runs
+ * when they are equal which, for a different key, is a 1 in 2^64 chance
+*/
+static long find_index(Ht_item **items, size_t size, const char *key, uint64_t key_hash, size_t *probes)
+{
+    size_t index = get_hash(key_hash, size, 0);
+    Ht_item *item = items[index];
+    // i is the number of collisions, a probe sequence never needs more than size attempts
+    size_t i = 1;
+    for (; item != NULL && i <= size; i++){
+        if (item->hash == key_hash && item != &DELETED_ITEM && strcmp(item->key, key) == 0){
+            *probes = i - 1;
+            return ((long)index);
+        }
+        index = get_hash(key_hash, size, i);
+        item = items[index];
+    }
+    *probes = i - 1;
+    return (-1);
+}
+
+/**
+ * thread_stats - finds the probe counters of the calling thread for a table
+ * @table: the table
+ * Return: the counters, or NULL if they cannot be allocated
+ * Description: the last block used is cached in a thread local, so this is two
+ * compares on every call but the first. Blocks are pushed on the table's list
+ * with a compare and swap, threads never wait on each other.
+*/
+static ThreadStats *thread_stats(HashTable *table)
+{
+    static _Thread_local char thread_marker;
+    static _Thread_local struct {
+        const HashTable *table;
+        uint64_t stats_id;
+        ThreadStats *stats;
+    } cache;
+    if (cache.table == table && cache.stats_id == table->stats_id)
+        return (cache.stats);
+    ThreadStats *stats = __atomic_load_n(&table->stats, __ATOMIC_ACQUIRE);
+    while (stats != NULL && stats->owner != &thread_marker)
+        stats = stats->next;
+    if (stats == NULL)
+    {
+        stats = calloc(1, sizeof(ThreadStats));
+        if (stats == NULL)
+            return (NULL);
+        stats->owner = &thread_marker;
+        stats->next = __atomic_load_n(&table->stats, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&table->stats, &stats->next, stats, 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+    cache.table = table;
+    cache.stats_id = table->stats_id;
+    cache.stats = stats;
+    return (stats);
+}
+
+/**
+ * count_probe - adds one probe sequence to a probe length histogram
+ * @histogram: one of the histograms of a ThreadStats
+ * @probes: the number of collisions of the probe sequence
+ * Description: relaxed atomic load and store rather than ++, so that
+ * hash_table_stats_dump can read the counters from another thread. Only the
+ * owner writes, so this still compiles to a plain increment.
+*/
+static inline void count_probe(uint64_t *histogram, size_t probes)
+{
+    uint64_t *counter = &histogram[probes < PROBE_HISTOGRAM_SIZE - 1 ? probes : PROBE_HISTOGRAM_SIZE - 1];
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * record_probes - records the probe length of an insert, lookup or delete when stats are on
+ * @table: the table that was probed
+ * @kind: which histogram to count it in
+ * @probes: the number of collisions of the probe sequence
+*/
+static inline void record_probes(HashTable *table, enum ProbeKind kind, size_t probes)
+{
+    if (!table->stats_enabled)
+        return;
+    ThreadStats *stats = thread_stats(table);
+    if (stats != NULL)
+        count_probe(stats->probes[kind], probes);
+}
+
+/**
+ * place_item - stores an item in the first free bucket of its probe sequence in table->items
+ * @table: the table receiving the item
+ * @item: the item to store
+ * Return: the number of collisions before the free bucket
+ * Description: a bucket is free if it is empty or holds the DELETED_ITEM sentinel
+*/
+static size_t place_item(HashTable *table, Ht_item *item)
+{
+    size_t index = get_hash(item->hash, table->size, 0);
     // retrieve the item currently stored at the calculated index position
     Ht_item *current_item = table->items[index];
     // i is the number of collisions
-    int i = 1;
+    size_t i = 1;
     // loop that continues as long as there is a collision at the calculated index 
     // (i.e., an item already exists at that index)
     while(current_item != NULL && current_item != &DELETED_ITEM)
     {
-        // recalculates the index by calling the ht_get_hash() function with an incremented value of i. 
+        // recalculates the index by calling the get_hash() function with an incremented value of i. 
         // This generates an alternative index to resolve the collision.
-        index = get_hash(new_item->key, table->size, i);
+        index = get_hash(item->hash, table->size, i);
         // Tries to retrieve an element to check if there is still a collision
         // if there is no collision, current_item should be NULL
         current_item = table->items[index];
         // if there is a collision, we increment i, i is the number of collisions witnessed so far
         i++;
     }
-    table->items[index] = new_item;
+    if (current_item == &DELETED_ITEM)
+        table->deleted--;
+    table->items[index] = item;
+    return (i - 1);
+}
+
+/**
+ * migrate - moves up to @steps buckets of the old array over to the new one
+ * @table: the table being resized
+ * @steps: the maximum number of old buckets to look at
+ * Description: a migrated bucket is left holding DELETED_ITEM rather than NULL,
+ * otherwise the probe chains of the old array that go through it would be cut
+ * and lookups of items that have not moved yet would stop early.
+ * Once every bucket has moved the old array is freed.
+*/
+static void migrate(HashTable *table, size_t steps)
+{
+    if (table->old_items == NULL)
+        return;
+    while (steps > 0 && table->migrate_index < table->old_size)
+    {
+        Ht_item *item = table->old_items[table->migrate_index];
+        if (item != NULL && item != &DELETED_ITEM)
+        {
+            place_item(table, item);
+            table->old_items[table->migrate_index] = &DELETED_ITEM;
+        }
+        table->migrate_index++;
+        steps--;
+    }
+    if (table->migrate_index == table->old_size)
+    {
+        free(table->old_items);
+        table->old_items = NULL;
+        table->old_size = 0;
+        table->migrate_index = 0;
+    }
+}
+
+/**
+ * start_resize - swaps in a new array of buckets and starts migrating to it
+ * @table: the table to resize
+ * @new_size: the number of buckets of the new array, a prime
+ * Return: 0 on success or -1 on failure (the table is left as it was)
+ * Description: only one resize can be in flight, so a still running one is
+ * finished first. That never happens in practice since a migration ends
+ * long before the new array can fill up
+*/
+static int start_resize(HashTable *table, size_t new_size)
+{
+    Ht_item **new_items = calloc(new_size, sizeof(Ht_item *));
+    if (new_items == NULL)
+        return (-1);
+    migrate(table, (size_t)-1);
+    table->old_items = table->items;
+    table->old_size = table->size;
+    table->migrate_index = 0;
+    table->items = new_items;
+    table->size = new_size;
+    table->deleted = 0;
+    table->resizes++;
+    return (0);
+}
+
+/**
+ * grow_if_needed - starts a resize when the next insert would push the load factor over MAX_LOAD
+ * @table: the table about to receive an item
+ * Description: tombstones count towards the load since they lengthen probe chains
+ * just like live items do. If it is mostly tombstones, we rehash into a table of
+ * the same size which clears them, otherwise the table doubles.
+*/
+static void grow_if_needed(HashTable *table)
+{
+    if (table->old_items != NULL)
+        return;
+    if ((table->count + table->deleted + 1) * 100 <= table->size * MAX_LOAD)
+        return;
+    size_t new_size = table->size;
+    if ((table->count + 1) * 100 > table->size * (MAX_LOAD / 2))
+        new_size = next_prime(table->size * 2);
+    start_resize(table, new_size);
+}
+
+/**
+ * shrink_if_needed - starts a resize to half the size when the load factor falls under MIN_LOAD
+ * @table: the table an item was just deleted from
+*/
+static void shrink_if_needed(HashTable *table)
+{
+    if (table->old_items != NULL || table->size <= INITIAL_SIZE)
+        return;
+    if (table->count * 100 >= table->size * MIN_LOAD)
+        return;
+    size_t new_size = next_prime(table->size / 2);
+    if (new_size < INITIAL_SIZE)
+        new_size = INITIAL_SIZE;
+    start_resize(table, new_size);
+}
+
+/**
+ * insert_hashed - inserts a key and a value whose hash is already known
+ * @table: the table to which we are inserting the key value pair
+ * @key: the key of a bucket
+ * @value: value associated to a certain bucket
+ * @key_hash: hash of @key
+*/
+static void insert_hashed(HashTable *table, const char *key, const char *value, uint64_t key_hash)
+{
+    // To insert a new key-value pair, we iterate through indexes until we find an empty bucket
+    // We then insert the item into that bucket and increment the hash table's count attribute
+    migrate(table, MIGRATE_STEP);
+    grow_if_needed(table);
+
+    // initialize the item
+    Ht_item *new_item = INITIALIZE_HASH_TABLE_ITEM(table, key, value, key_hash);
+    if (new_item == NULL)
+        return;
+    record_probes(table, PROBE_INSERT, place_item(table, new_item));
     table->count++;
 }
 
+/**
+ * find_item - finds the item of a key whose hash is already known, in both arrays during a resize
+ * @table: the table from which we try to locate the item
+ * @key: the key to use for searching
+ * @key_hash: hash of @key
+ * @probes: gets the number of collisions, a lookup that had to go on to the
+ * old array pays for both probes
+ * Return: the item or NULL if no item is found
+*/
+static Ht_item *find_item(HashTable *table, const char *key, uint64_t key_hash, size_t *probes)
+{
+    long index = find_index(table->items, table->size, key, key_hash, probes);
+    if (index >= 0)
+        return table->items[index];
+    // while a resize is going on, the item may not have been migrated yet
+    if (table->old_items != NULL)
+    {
+        size_t old_probes;
+        index = find_index(table->old_items, table->old_size, key, key_hash, &old_probes);
+        *probes += old_probes + 1;
+        if (index >= 0)
+            return table->old_items[index];
+    }
+    return NULL;
+}
+
+/**
+ * lookup - finds the value of a key whose hash is already known
+ * @table: the table from which we try to locate the value
+ * @key: the key to use for searching
+ * @key_hash: hash of @key
+ * Return: the found value associated with key or NULL if no item is found
+*/
+static char *lookup(HashTable *table, const char *key, uint64_t key_hash)
+{
+    size_t probes;
+    Ht_item *item = find_item(table, key, key_hash, &probes);
+    record_probes(table, item != NULL ? PROBE_HIT : PROBE_MISS, probes);
+    return item != NULL ? item->value : NULL;
+}
+
+/**
+ * insert - inserts a key and a value (a bucket) to a given hash table
+ * @table: the table to which we are inserting the key value pair
+ * @key: the key of a bucket
+ * @value: value associated to a certain bucket
+*/
+void insert(HashTable *table, const char *key, const char *value)
+{
+    insert_hashed(table, key, value, hash(key, strlen(key), table->seed));
+}
+
 /**
  * search - tries to locate a value given a key
  * @table: the table from which we try to locate the value
@@ -160,23 +814,13 @@ void insert(HashTable *table, const char *key, const char *value)
  * we check whether the item's key matches the key we're searching for. 
  * If it does, we return the item's value.
  *  If the while loop hits a NULL bucket, we return NULL, to indicate that no value was found.
+ * The value points into the table's arena, it stays readable until the table is
+ * compacted or deleted, after an update or delete of the key it holds the old value
 */
 char *search(HashTable *table, const char *key)
 {
-    int index = get_hash(key, table->size, 0);
-    Ht_item *item = table->items[index];
-    int i = 1;
-    while (item != NULL && item){
-        if (item != &DELETED_ITEM){
-            if(strcmp(item->key, key) == 0){
-                return item->value;
-            }
-        }
-        index = get_hash(key, table->size, i);
-        item = table->items[index];
-        i++;
-    }
-    return NULL;
+    migrate(table, MIGRATE_STEP);
+    return lookup(table, key, hash(key, strlen(key), table->seed));
 }
 
 // deleting logic
@@ -199,28 +843,858 @@ char *search(HashTable *table, const char *key)
 */
 void delete(HashTable *table, const char *key)
 {
-    int index = get_hash(key, table->size, 0);
-    Ht_item *item = table->items[index];
-    int i = 1;
-    while (item != NULL){
-        // if the current item is not marked as deleted, then it is a valid candidate for comparison
-        if (item != &DELETED_ITEM){
-            if (strcmp(item->key, key) == 0){
-                delete_ht_item(item);
-                table->items[index] = &DELETED_ITEM;
+    migrate(table, MIGRATE_STEP);
+    const uint64_t key_hash = hash(key, strlen(key), table->seed);
+    size_t probes;
+    long index = find_index(table->items, table->size, key, key_hash, &probes);
+    if (index >= 0){
+        record_probes(table, PROBE_DELETE, probes);
+        delete_ht_item(table, table->items[index]);
+        table->items[index] = &DELETED_ITEM;
+        table->deleted++;
+    } else if (table->old_items != NULL) {
+        // not migrated yet, the tombstone in the old array is never counted since that array is going away
+        size_t old_probes;
+        index = find_index(table->old_items, table->old_size, key, key_hash, &old_probes);
+        record_probes(table, PROBE_DELETE, probes + old_probes + 1);
+        if (index < 0)
+            return;
+        delete_ht_item(table, table->old_items[index]);
+        table->old_items[index] = &DELETED_ITEM;
+    } else {
+        // the key is not in the table, nothing to delete
+        record_probes(table, PROBE_DELETE, probes);
+        return;
+    }
+    table->count--;
+    shrink_if_needed(table);
+}
+
+/**
+ * search_batch - looks up many keys at once
+ * @table: the table from which we try to locate the values
+ * @keys: the keys to look up
+ * @n: number of keys
+ * @values_out: gets the value of every key, or NULL for keys that are not in the table
+ * Description: a loop over search stalls on a cache miss for every bucket and
+ * every item. Here keys go through in groups of BATCH_GROUP: first every key of
+ * the group is hashed and the cache line of its first bucket prefetched, then
+ * the item in each of those buckets is prefetched, then the keys are resolved.
+ * By the time a key is resolved its first bucket and item are (mostly) in cache,
+ * and the misses of the whole group have overlapped.
+ * The probe sequence is the one of search so the results are the same as
+ * calling search for every key, and the table migrates as much as n searches would.
+*/
+void search_batch(HashTable *table, const char *const keys[], size_t n, char *values_out[])
+{
+    uint64_t hashes[BATCH_GROUP];
+    size_t first[BATCH_GROUP];
+    migrate(table, n * MIGRATE_STEP);
+    for (size_t base = 0; base < n; base += BATCH_GROUP)
+    {
+        const size_t group = n - base < BATCH_GROUP ? n - base : BATCH_GROUP;
+        // stage 1: hash every key and prefetch its first bucket
+        for (size_t j = 0; j < group; j++)
+        {
+            hashes[j] = hash(keys[base + j], strlen(keys[base + j]), table->seed);
+            first[j] = get_hash(hashes[j], table->size, 0);
+            __builtin_prefetch(&table->items[first[j]]);
+            if (table->old_items != NULL)
+                __builtin_prefetch(&table->old_items[get_hash(hashes[j], table->old_size, 0)]);
+        }
+        // stage 2: prefetch the item sitting in the first bucket
+        for (size_t j = 0; j < group; j++)
+        {
+            Ht_item *item = table->items[first[j]];
+            if (item != NULL)
+                __builtin_prefetch(item);
+        }
+        // stage 3: resolve, the first probe of every key now hits the cache
+        for (size_t j = 0; j < group; j++)
+            values_out[base + j] = lookup(table, keys[base + j], hashes[j]);
+    }
+}
+
+/**
+ * insert_batch - inserts many key value pairs at once
+ * @table: the table to which we are inserting the key value pairs
+ * @keys: the keys
+ * @values: the value of every key
+ * @n: number of pairs
+ * Description: like search_batch, the keys of a group are hashed and their
+ * first buckets prefetched before any of them is inserted. The pairs are
+ * inserted in order, so the table ends up as if insert had been called
+ * for every pair. A resize started in the middle of a group makes the
+ * remaining prefetches useless but not wrong.
+*/
+void insert_batch(HashTable *table, const char *const keys[], const char *const values[], size_t n)
+{
+    uint64_t hashes[BATCH_GROUP];
+    for (size_t base = 0; base < n; base += BATCH_GROUP)
+    {
+        const size_t group = n - base < BATCH_GROUP ? n - base : BATCH_GROUP;
+        for (size_t j = 0; j < group; j++)
+        {
+            hashes[j] = hash(keys[base + j], strlen(keys[base + j]), table->seed);
+            __builtin_prefetch(&table->items[get_hash(hashes[j], table->size, 0)], 1);
+        }
+        for (size_t j = 0; j < group; j++)
+            insert_hashed(table, keys[base + j], values[base + j], hashes[j]);
+    }
+}
+
+/**
+ * hash_table_stats_enable - turns probe length counting on or off
+ * @table: the table
+ * @enabled: 1 to count, 0 to stop counting (the counts so far are kept)
+*/
+void hash_table_stats_enable(HashTable *table, int enabled)
+{
+    table->stats_enabled = enabled;
+}
+
+/**
+ * longest_cluster - finds the longest run of occupied buckets
+ * @items: the buckets
+ * @size: number of buckets
+ * Return: the length of the longest run of buckets holding an item or a tombstone,
+ * a run that wraps around the end of the array counts as one
+*/
+static size_t longest_cluster(Ht_item **items, size_t size)
+{
+    size_t longest = 0;
+    size_t run = 0;
+    size_t leading = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (items[i] == NULL)
+        {
+            if (run == i)
+                leading = run;
+            run = 0;
+            continue;
+        }
+        run++;
+        if (run > longest)
+            longest = run;
+    }
+    if (run == size)
+        return (size);
+    if (run + leading > longest)
+        longest = run + leading;
+    return (longest);
+}
+
+/**
+ * print_histogram - prints a probe length histogram as a JSON array
+ * @out: where to print
+ * @name: the JSON key of the array
+ * @histogram: the counts
+*/
+static void print_histogram(FILE *out, const char *name, const uint64_t *histogram)
+{
+    fprintf(out, "\"%s\":[", name);
+    for (int i = 0; i < PROBE_HISTOGRAM_SIZE; i++)
+        fprintf(out, "%s%llu", i ? "," : "", (unsigned long long)histogram[i]);
+    fprintf(out, "]");
+}
+
+/**
+ * hash_table_stats_dump - prints the state of a table as one line of JSON
+ * @table: the table
+ * @out: where to print
+ * Description: the probe histograms are the per thread counters added up, entry i
+ * counts probe sequences that ran into i collisions and the last entry everything longer.
+ * The rest (tombstones, load factor, longest cluster, bytes used) is measured
+ * on the spot, the longest cluster by a scan of the buckets.
+*/
+void hash_table_stats_dump(HashTable *table, FILE *out)
+{
+    static const char *const names[PROBE_KINDS] = {"hit_probes", "miss_probes", "insert_probes", "delete_probes"};
+    uint64_t probes[PROBE_KINDS][PROBE_HISTOGRAM_SIZE] = {{0}};
+    size_t bytes = sizeof(HashTable) + (table->size + table->old_size) * sizeof(Ht_item *);
+    for (ThreadStats *stats = __atomic_load_n(&table->stats, __ATOMIC_ACQUIRE); stats != NULL; stats = stats->next)
+    {
+        for (int kind = 0; kind < PROBE_KINDS; kind++)
+            for (int i = 0; i < PROBE_HISTOGRAM_SIZE; i++)
+                probes[kind][i] += __atomic_load_n(&stats->probes[kind][i], __ATOMIC_RELAXED);
+        bytes += sizeof(ThreadStats);
+    }
+    for (ArenaSlab *slab = table->slabs; slab != NULL; slab = slab->next)
+        bytes += sizeof(ArenaSlab) + slab->capacity;
+    fprintf(out, "{\"count\":%zu,\"size\":%zu,\"tombstones\":%zu,\"load_factor\":%.4f,"
+            "\"longest_cluster\":%zu,\"resizes\":%zu,\"resize_in_progress\":%s,"
+            "\"bytes_used\":%zu,\"arena_used\":%zu,\"arena_dead\":%zu,",
+            table->count, table->size, table->deleted,
+            (double)(table->count + table->deleted) / table->size,
+            longest_cluster(table->items, table->size), table->resizes,
+            table->old_items != NULL ? "true" : "false",
+            bytes, table->arena_used, table->arena_dead);
+    for (int kind = 0; kind < PROBE_KINDS; kind++)
+    {
+        if (kind)
+            fprintf(out, ",");
+        print_histogram(out, names[kind], probes[kind]);
+    }
+    fprintf(out, "}\n");
+}
+
+// snapshot files start with this magic, followed by the version of the layout
+#define SNAPSHOT_MAGIC "HTSNAP\0\0"
+#define SNAPSHOT_VERSION 1
+// written in native byte order, a file from a machine of the other byte order reads back differently
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+// marks an empty bucket of a snapshot
+#define SNAPSHOT_EMPTY UINT64_MAX
+
+/*
+ * SnapshotHeader - the first bytes of a snapshot file
+ * @magic: SNAPSHOT_MAGIC
+ * @version: SNAPSHOT_VERSION
+ * @byte_order: SNAPSHOT_BYTE_ORDER as written by the machine that saved the file
+ * @seed: the seed the keys were hashed with
+ * @size: number of buckets, a prime
+ * @count: number of items
+ * @buckets_offset: file offset of the bucket array
+ * @data_offset: file offset of the item records
+ * @data_size: bytes of item records
+ * @checksum: checksum of everything that follows the header
+ * Description: everything in the file is located by offsets, nothing by address,
+ * so the file can be mapped anywhere and used as it is
+ */
+typedef struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t seed;
+    uint64_t size;
+    uint64_t count;
+    uint64_t buckets_offset;
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint64_t checksum;
+} SnapshotHeader;
+
+/*
+ * SnapshotBucket - a bucket of a snapshot
+ * @hash: hash of the key of the item
+ * @item_offset: offset of the item record from the start of the records,
+ * SNAPSHOT_EMPTY for an empty bucket
+ * Description: an item record is the key length and the value length (32 bits each)
+ * followed by the key and the value with their terminators, padded to 8 bytes
+ */
+typedef struct SnapshotBucket {
+    uint64_t hash;
+    uint64_t item_offset;
+} SnapshotBucket;
+
+/*
+ * MappedHashTable - a read only hash table served straight from a mapped snapshot
+ * @base: start of the mapping
+ * @length: length of the mapping
+ * @header: the header of the snapshot
+ * @buckets: the buckets of the snapshot
+ * @data: the item records of the snapshot
+ */
+typedef struct MappedHashTable {
+    void *base;
+    size_t length;
+    const SnapshotHeader *header;
+    const SnapshotBucket *buckets;
+    const unsigned char *data;
+} MappedHashTable;
+
+/**
+ * checksum_update - folds 8 byte aligned data into a running checksum
+ * @state: the checksum so far
+ * @data: the data, its length a multiple of 8
+ * @len: length of @data
+ * Return: the new checksum
+*/
+static uint64_t checksum_update(uint64_t state, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i += 8)
+        state = hash_mix(state ^ read_word(p + i), HASH_P1);
+    return (state);
+}
+
+/**
+ * snapshot_add_item - puts an item of the table into the bucket array of a snapshot
+ * @buckets: the snapshot buckets
+ * @size: number of snapshot buckets
+ * @item: the item
+ * @data_size: bytes of records so far, the item's record goes right after them
+ * Return: the new number of bytes of records
+*/
+static uint64_t snapshot_add_item(SnapshotBucket *buckets, size_t size, const Ht_item *item, uint64_t data_size)
+{
+    size_t index = get_hash(item->hash, size, 0);
+    for (size_t i = 1; buckets[index].item_offset != SNAPSHOT_EMPTY; i++)
+        index = get_hash(item->hash, size, i);
+    buckets[index].hash = item->hash;
+    buckets[index].item_offset = data_size;
+    return (data_size + ((8 + item->key_len + item->value_len + 2 + 7) & ~(uint64_t)7));
+}
+
+/**
+ * snapshot_write_item - writes the record of an item to a snapshot file
+ * @file: the snapshot file
+ * @item: the item
+ * @checksum: the running checksum, updated with the record
+ * Return: 0 on success or -1 on failure
+*/
+static int snapshot_write_item(FILE *file, const Ht_item *item, uint64_t *checksum)
+{
+    unsigned char padding[8] = {0};
+    const uint32_t lengths[2] = {item->key_len, item->value_len};
+    const size_t record = 8 + item->key_len + item->value_len + 2;
+    const size_t pad = ((record + 7) & ~(size_t)7) - record;
+    if (fwrite(lengths, sizeof(lengths), 1, file) != 1 ||
+        fwrite(item->key, 1, item->key_len + 1, file) != item->key_len + 1 ||
+        fwrite(item->value, 1, item->value_len + 1, file) != item->value_len + 1 ||
+        fwrite(padding, 1, pad, file) != pad)
+        return (-1);
+    // checksum the record as it sits in the file, padding included
+    unsigned char *bytes = malloc(record + pad);
+    if (bytes == NULL)
+        return (-1);
+    memcpy(bytes, lengths, sizeof(lengths));
+    memcpy(bytes + 8, item->key, item->key_len + 1);
+    memcpy(bytes + 9 + item->key_len, item->value, item->value_len + 1);
+    memset(bytes + record, 0, pad);
+    *checksum = checksum_update(*checksum, bytes, record + pad);
+    free(bytes);
+    return (0);
+}
+
+/**
+ * snapshot_items - runs through every live item of a table, in both bucket arrays
+ * @table: the table
+ * @position: where we are, start it at 0
+ * Return: the next item, or NULL once every item has been seen
+*/
+static Ht_item *snapshot_items(const HashTable *table, size_t *position)
+{
+    while (*position < table->size + table->old_size)
+    {
+        const size_t i = (*position)++;
+        Ht_item *item = i < table->size ? table->items[i] : table->old_items[i - table->size];
+        if (item != NULL && item != &DELETED_ITEM)
+            return (item);
+    }
+    return (NULL);
+}
+
+/**
+ * hash_table_save - writes a table to a snapshot file
+ * @table: the table to save
+ * @path: where to write the snapshot
+ * Return: 0 on success or -1 on failure
+ * Description: the snapshot has its own bucket array sized for the items it
+ * holds (no tombstones, no migration in flight) and keeps the seed of the table,
+ * so it is probed with the same get_hash as the table. The file is written
+ * next to @path and renamed over it once complete, a reader never maps half a snapshot.
+*/
+int hash_table_save(const HashTable *table, const char *path)
+{
+    const size_t size = next_prime(table->count * 2 + 3);
+    SnapshotBucket *buckets = malloc(size * sizeof(SnapshotBucket));
+    if (buckets == NULL)
+        return (-1);
+    for (size_t i = 0; i < size; i++)
+        buckets[i] = (SnapshotBucket){0, SNAPSHOT_EMPTY};
+    SnapshotHeader header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, SNAPSHOT_BYTE_ORDER, table->seed, size,
+                             table->count, sizeof(SnapshotHeader), 0, 0, 0};
+    header.data_offset = header.buckets_offset + size * sizeof(SnapshotBucket);
+    size_t position = 0;
+    for (Ht_item *item = snapshot_items(table, &position); item != NULL; item = snapshot_items(table, &position))
+        header.data_size = snapshot_add_item(buckets, size, item, header.data_size);
+    header.checksum = checksum_update(0, buckets, size * sizeof(SnapshotBucket));
+
+    char *tmp_path = malloc(strlen(path) + 5);
+    if (tmp_path == NULL)
+    {
+        free(buckets);
+        return (-1);
+    }
+    sprintf(tmp_path, "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    int failed = file == NULL;
+    // the header goes in last, once the checksum is known
+    if (!failed)
+        failed = fseek(file, sizeof(SnapshotHeader), SEEK_SET) != 0 ||
+                 fwrite(buckets, sizeof(SnapshotBucket), size, file) != size;
+    position = 0;
+    for (Ht_item *item = snapshot_items(table, &position); !failed && item != NULL; item = snapshot_items(table, &position))
+        failed = snapshot_write_item(file, item, &header.checksum) != 0;
+    if (!failed)
+        failed = fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1;
+    if (file != NULL && fclose(file) != 0)
+        failed = 1;
+    if (!failed)
+        failed = rename(tmp_path, path) != 0;
+    if (failed)
+        remove(tmp_path);
+    free(tmp_path);
+    free(buckets);
+    return (failed ? -1 : 0);
+}
+
+/**
+ * hash_table_open_mmap - maps a snapshot file as a read only table
+ * @path: the snapshot file
+ * Return: the mapped table or NULL if the file cannot be mapped or is not a valid snapshot
+ * Description: only the header is checked here, so opening costs the same for
+ * any size of snapshot and pages are read in as lookups touch them.
+ * hash_table_verify_mmap checks the checksum when reading the whole file is affordable
+*/
+MappedHashTable *hash_table_open_mmap(const char *path)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return (NULL);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return (NULL);
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return (NULL);
+    const SnapshotHeader *header = base;
+    const uint64_t length = (uint64_t)st.st_size;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, 8) != 0 || header->version != SNAPSHOT_VERSION ||
+        header->byte_order != SNAPSHOT_BYTE_ORDER || header->size < 2 ||
+        header->buckets_offset != sizeof(SnapshotHeader) ||
+        header->size > (length - header->buckets_offset) / sizeof(SnapshotBucket) ||
+        header->data_offset != header->buckets_offset + header->size * sizeof(SnapshotBucket) ||
+        header->data_size > length - header->data_offset)
+    {
+        munmap(base, (size_t)st.st_size);
+        return (NULL);
+    }
+    MappedHashTable *mapped = malloc(sizeof(MappedHashTable));
+    if (mapped == NULL)
+    {
+        munmap(base, (size_t)st.st_size);
+        return (NULL);
+    }
+    mapped->base = base;
+    mapped->length = (size_t)st.st_size;
+    mapped->header = header;
+    mapped->buckets = (const SnapshotBucket *)((const unsigned char *)base + header->buckets_offset);
+    mapped->data = (const unsigned char *)base + header->data_offset;
+    return (mapped);
+}
+
+/**
+ * hash_table_verify_mmap - checks the checksum of a mapped snapshot
+ * @mapped: the mapped table
+ * Return: 1 if the checksum matches, 0 otherwise
+ * Description: this reads every page of the file
+*/
+int hash_table_verify_mmap(const MappedHashTable *mapped)
+{
+    const SnapshotHeader *header = mapped->header;
+    uint64_t checksum = checksum_update(0, mapped->buckets, header->size * sizeof(SnapshotBucket));
+    checksum = checksum_update(checksum, mapped->data, header->data_size & ~(uint64_t)7);
+    return (checksum == header->checksum);
+}
+
+/**
+ * hash_table_close_mmap - unmaps a snapshot
+ * @mapped: the mapped table, values returned by mapped_search are gone after this
+*/
+void hash_table_close_mmap(MappedHashTable *mapped)
+{
+    munmap(mapped->base, mapped->length);
+    free(mapped);
+}
+
+/**
+ * mapped_search - tries to locate a value given a key, in a mapped snapshot
+ * @mapped: the mapped table
+ * @key: the key to use for searching
+ * Return: the found value, pointing into the mapping, or NULL if no item is found
+ * Description: the same probe as search over the snapshot's buckets, nothing is
+ * copied or decoded. Record offsets are bounds checked as they are used, so a
+ * damaged file gives wrong answers rather than reads outside the mapping
+*/
+const char *mapped_search(const MappedHashTable *mapped, const char *key)
+{
+    const SnapshotHeader *header = mapped->header;
+    const size_t key_len = strlen(key);
+    const uint64_t key_hash = hash(key, key_len, header->seed);
+    size_t index = get_hash(key_hash, header->size, 0);
+    for (size_t i = 1; i <= header->size; i++)
+    {
+        const SnapshotBucket *bucket = &mapped->buckets[index];
+        if (bucket->item_offset == SNAPSHOT_EMPTY)
+            return (NULL);
+        if (bucket->hash == key_hash && header->data_size >= 8 && bucket->item_offset <= header->data_size - 8)
+        {
+            const unsigned char *record = mapped->data + bucket->item_offset;
+            uint32_t lengths[2];
+            memcpy(lengths, record, sizeof(lengths));
+            if (lengths[0] == key_len &&
+                (uint64_t)lengths[0] + lengths[1] + 10 <= header->data_size - bucket->item_offset &&
+                memcmp(record + 8, key, key_len) == 0)
+                return ((const char *)record + 9 + key_len);
+        }
+        index = get_hash(key_hash, header->size, i);
+    }
+    return (NULL);
+}
+
+// average number of keys per bucket of a frozen table, more keys per bucket
+// means fewer pilots to store but a longer search for each pilot
+#define FROZEN_BUCKET_KEYS 4
+// a bucket with more keys than this is given up on (the odds are astronomically small)
+#define FROZEN_MAX_BUCKET 64
+// a bucket needing more pilot tries than this is given up on
+#define FROZEN_MAX_PILOT (1u << 24)
+
+/*
+ * FrozenHashTable - an immutable table built by hash_table_freeze
+ * @count: number of keys
+ * @num_slots: number of slots the pilots place keys into, a few percent more than @count
+ * @num_buckets: number of buckets, each with its own pilot
+ * @seed: the seed the keys were hashed with (the one of the original table)
+ * @pilots: the pilot of every bucket
+ * @remap: for each slot at or past @count, the slot under @count to read instead: the
+ * free slot its key moved to, or slot 0 when it holds no key, so a miss is still
+ * rejected by the key comparison
+ * @offsets: where the record of the key in each slot starts in @data
+ * @data: the records, one after the other in slot order, each the key length and
+ * value length (32 bits each) then the key and the value with their terminators
+ * @data_size: bytes in @data
+ * Description: a minimal perfect hash in the PTHash style. A key's hash picks a
+ * bucket, and the pilot of that bucket was chosen when freezing so that every
+ * key lands in a slot of its own. A lookup is one hash, one pilot, one offset and
+ * one record compare, for hits and misses alike.
+ */
+typedef struct FrozenHashTable {
+    size_t count;
+    size_t num_slots;
+    size_t num_buckets;
+    uint64_t seed;
+    uint32_t *pilots;
+    uint32_t *remap;
+    uint32_t *offsets;
+    unsigned char *data;
+    size_t data_size;
+} FrozenHashTable;
+
+/**
+ * scale - maps a 64 bit number onto [0, n) with a multiply instead of a division
+ * @x: the number, its high bits matter most
+ * @n: the size of the range
+ * Return: the scaled number
+*/
+static inline size_t scale(uint64_t x, size_t n)
+{
+    return ((size_t)(((__uint128_t)x * n) >> 64));
+}
+
+/**
+ * frozen_bucket - the bucket of a key in a frozen table
+ * @frozen: the table
+ * @key_hash: hash of the key
+ * Return: the bucket
+*/
+static inline size_t frozen_bucket(const FrozenHashTable *frozen, uint64_t key_hash)
+{
+    return (scale(key_hash, frozen->num_buckets));
+}
+
+/**
+ * frozen_slot - the slot a pilot sends a key to, before remapping
+ * @frozen: the table
+ * @key_hash: hash of the key
+ * @pilot: the pilot of the key's bucket
+ * Return: a slot in [0, num_slots)
+*/
+static inline size_t frozen_slot(const FrozenHashTable *frozen, uint64_t key_hash, uint32_t pilot)
+{
+    return (scale(hash_mix(key_hash ^ HASH_P2, HASH_P1 ^ (pilot * HASH_P0)), frozen->num_slots));
+}
+
+/**
+ * compare_item_hashes - qsort comparison of items by hash
+ * @a: pointer to the first Ht_item pointer
+ * @b: pointer to the second Ht_item pointer
+ * Return: negative, zero or positive as the hash of @a is below, equal to or above that of @b
+*/
+static int compare_item_hashes(const void *a, const void *b)
+{
+    const uint64_t hash_a = (*(Ht_item *const *)a)->hash;
+    const uint64_t hash_b = (*(Ht_item *const *)b)->hash;
+    return ((hash_a > hash_b) - (hash_a < hash_b));
+}
+
+/**
+ * delete_frozen_table - frees a frozen table
+ * @frozen: the table to free
+*/
+void delete_frozen_table(FrozenHashTable *frozen)
+{
+    free(frozen->pilots);
+    free(frozen->remap);
+    free(frozen->offsets);
+    free(frozen->data);
+    free(frozen);
+}
+
+/**
+ * collect_items - gets the live items of a table sorted by hash, one per key
+ * @table: the table
+ * @count: gets the number of items
+ * Return: the items or NULL on failure (or if two keys share a 64 bit hash)
+ * Description: insert does not check for an existing key, so a key can be in the
+ * table more than once. Of those the one search would find is kept.
+*/
+static Ht_item **collect_items(HashTable *table, size_t *count)
+{
+    Ht_item **items = malloc((table->count + 1) * sizeof(Ht_item *));
+    if (items == NULL)
+        return (NULL);
+    size_t n = 0;
+    size_t position = 0;
+    for (Ht_item *item = snapshot_items(table, &position); item != NULL; item = snapshot_items(table, &position))
+        items[n++] = item;
+    qsort(items, n, sizeof(Ht_item *), compare_item_hashes);
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (kept > 0 && items[kept - 1]->hash == items[i]->hash)
+        {
+            // no pilot can separate two keys with the same hash
+            if (strcmp(items[kept - 1]->key, items[i]->key) != 0)
+            {
+                free(items);
+                return (NULL);
             }
+            // find_item rather than lookup, freezing is not a lookup the stats should count
+            size_t probes;
+            if (find_item(table, items[i]->key, items[i]->hash, &probes) == items[i])
+                items[kept - 1] = items[i];
+            continue;
         }
-        index = get_hash(key, table->size, i);
-        item = table->items[index];
-        i++;
+        items[kept++] = items[i];
     }
-    table->count--;
+    *count = kept;
+    return (items);
+}
+
+/**
+ * find_pilots - chooses the pilot of every bucket, biggest buckets first
+ * @frozen: the table being built, @pilots is filled in
+ * @items: the items sorted by hash
+ * @slot_items: gets the item placed in each slot (num_slots entries, NULL for free slots)
+ * Return: 0 on success or -1 on failure
+ * Description: big buckets are the hardest to fit so they go while the slots are
+ * still mostly free. For each bucket we try pilots 0, 1, 2... until all its keys
+ * land in distinct free slots.
+*/
+static int find_pilots(FrozenHashTable *frozen, Ht_item **items, Ht_item **slot_items)
+{
+    const size_t n = frozen->count;
+    const size_t num_buckets = frozen->num_buckets;
+    // items are sorted by hash and buckets are picked by the high bits of the hash,
+    // so the keys of a bucket are next to each other: bucket b is items[start[b]..start[b + 1])
+    size_t *start = calloc(num_buckets + 1, sizeof(size_t));
+    size_t *order = malloc(num_buckets * sizeof(size_t));
+    size_t *by_size = calloc(FROZEN_MAX_BUCKET + 2, sizeof(size_t));
+    if (start == NULL || order == NULL || by_size == NULL)
+    {
+        free(start);
+        free(order);
+        free(by_size);
+        return (-1);
+    }
+    for (size_t i = 0; i < n; i++)
+        start[frozen_bucket(frozen, items[i]->hash) + 1]++;
+    for (size_t b = 0; b < num_buckets; b++)
+    {
+        if (start[b + 1] > FROZEN_MAX_BUCKET)
+        {
+            free(start);
+            free(order);
+            free(by_size);
+            return (-1);
+        }
+        by_size[FROZEN_MAX_BUCKET - start[b + 1] + 1]++;
+        start[b + 1] += start[b];
+    }
+    // counting sort of the buckets, biggest first
+    for (size_t s = 1; s <= FROZEN_MAX_BUCKET + 1; s++)
+        by_size[s] += by_size[s - 1];
+    for (size_t b = 0; b < num_buckets; b++)
+        order[by_size[FROZEN_MAX_BUCKET - (start[b + 1] - start[b])]++] = b;
+
+    int failed = 0;
+    size_t slots[FROZEN_MAX_BUCKET];
+    for (size_t o = 0; o < num_buckets && !failed; o++)
+    {
+        const size_t b = order[o];
+        const size_t bucket_size = start[b + 1] - start[b];
+        if (bucket_size == 0)
+            break;
+        uint32_t pilot = 0;
+        for (;; pilot++)
+        {
+            if (pilot == FROZEN_MAX_PILOT)
+            {
+                failed = 1;
+                break;
+            }
+            size_t placed = 0;
+            for (; placed < bucket_size; placed++)
+            {
+                slots[placed] = frozen_slot(frozen, items[start[b] + placed]->hash, pilot);
+                if (slot_items[slots[placed]] != NULL)
+                    break;
+                size_t j = 0;
+                while (j < placed && slots[j] != slots[placed])
+                    j++;
+                if (j < placed)
+                    break;
+            }
+            if (placed == bucket_size)
+                break;
+        }
+        if (failed)
+            break;
+        frozen->pilots[b] = pilot;
+        for (size_t j = 0; j < bucket_size; j++)
+            slot_items[slots[j]] = items[start[b] + j];
+    }
+    free(start);
+    free(order);
+    free(by_size);
+    return (failed ? -1 : 0);
+}
+
+/**
+ * pack_records - moves keys past the last slot into the free slots below it and
+ * writes the records in slot order
+ * @frozen: the table being built, @remap, @offsets and @data are filled in
+ * @slot_items: the item placed in each slot
+ * Return: 0 on success or -1 on failure
+*/
+static int pack_records(FrozenHashTable *frozen, Ht_item **slot_items)
+{
+    const size_t n = frozen->count;
+    size_t free_slot = 0;
+    size_t data_size = 0;
+    for (size_t p = n; p < frozen->num_slots; p++)
+    {
+        // a missing key can land on an empty slot too, send it to a real record
+        if (slot_items[p] == NULL)
+        {
+            frozen->remap[p - n] = 0;
+            continue;
+        }
+        // there are exactly as many free slots under n as taken slots past it
+        while (slot_items[free_slot] != NULL)
+            free_slot++;
+        frozen->remap[p - n] = (uint32_t)free_slot;
+        slot_items[free_slot] = slot_items[p];
+    }
+    for (size_t p = 0; p < n; p++)
+        data_size += 8 + slot_items[p]->key_len + slot_items[p]->value_len + 2;
+    if (data_size > UINT32_MAX)
+        return (-1);
+    frozen->data = malloc(data_size ? data_size : 1);
+    if (frozen->data == NULL)
+        return (-1);
+    frozen->data_size = data_size;
+    size_t offset = 0;
+    for (size_t p = 0; p < n; p++)
+    {
+        const Ht_item *item = slot_items[p];
+        const uint32_t lengths[2] = {item->key_len, item->value_len};
+        frozen->offsets[p] = (uint32_t)offset;
+        memcpy(frozen->data + offset, lengths, sizeof(lengths));
+        memcpy(frozen->data + offset + 8, item->key, item->key_len + 1);
+        memcpy(frozen->data + offset + 9 + item->key_len, item->value, item->value_len + 1);
+        offset += 8 + item->key_len + item->value_len + 2;
+    }
+    return (0);
+}
+
+/**
+ * hash_table_freeze - builds an immutable minimal perfect hash table from a table
+ * @table: the table to freeze, it is not changed and can be deleted afterwards
+ * Return: the frozen table, or NULL on failure
+ * Description: keys and values are copied into one block in slot order. Per key
+ * this costs a 4 byte offset, an 8 byte record header, about a byte of pilot and
+ * the strings, where the table costs a bucket pointer, an Ht_item and the strings.
+*/
+FrozenHashTable *hash_table_freeze(HashTable *table)
+{
+    FrozenHashTable *frozen = calloc(1, sizeof(FrozenHashTable));
+    size_t n = 0;
+    Ht_item **items = collect_items(table, &n);
+    if (frozen == NULL || items == NULL || n > UINT32_MAX)
+    {
+        free(frozen);
+        free(items);
+        return (NULL);
+    }
+    frozen->count = n;
+    frozen->num_slots = n + n / 32 + 1;
+    frozen->num_buckets = n / FROZEN_BUCKET_KEYS + 1;
+    frozen->seed = table->seed;
+    frozen->pilots = calloc(frozen->num_buckets, sizeof(uint32_t));
+    frozen->remap = malloc((frozen->num_slots - n) * sizeof(uint32_t));
+    frozen->offsets = malloc((n ? n : 1) * sizeof(uint32_t));
+    Ht_item **slot_items = calloc(frozen->num_slots, sizeof(Ht_item *));
+    if (frozen->pilots == NULL || frozen->remap == NULL || frozen->offsets == NULL || slot_items == NULL ||
+        find_pilots(frozen, items, slot_items) != 0 || pack_records(frozen, slot_items) != 0)
+    {
+        free(slot_items);
+        free(items);
+        delete_frozen_table(frozen);
+        return (NULL);
+    }
+    free(slot_items);
+    free(items);
+    return (frozen);
+}
+
+/**
+ * frozen_search - tries to locate a value given a key, in a frozen table
+ * @frozen: the frozen table
+ * @key: the key to use for searching
+ * Return: the found value associated with key or NULL if no item is found
+ * Description: no probing, the pilot gives the only slot the key can be in
+*/
+const char *frozen_search(const FrozenHashTable *frozen, const char *key)
+{
+    if (frozen->count == 0)
+        return (NULL);
+    const size_t key_len = strlen(key);
+    const uint64_t key_hash = hash(key, key_len, frozen->seed);
+    size_t slot = frozen_slot(frozen, key_hash, frozen->pilots[frozen_bucket(frozen, key_hash)]);
+    if (slot >= frozen->count)
+        slot = frozen->remap[slot - frozen->count];
+    const unsigned char *record = frozen->data + frozen->offsets[slot];
+    uint32_t lengths[2];
+    memcpy(lengths, record, sizeof(lengths));
+    if (lengths[0] != key_len || memcmp(record + 8, key, key_len) != 0)
+        return (NULL);
+    return ((const char *)record + 9 + key_len);
 }
 
 int main()
 {
     printf("Hash tables\n");
     HashTable *table = INITIALIZE_HASHTABLE();
+    hash_table_stats_enable(table, 1);
     insert(table, "cat", "meows");
     insert(table, "tac", "weoms");
     insert(table, "dog", "barks");
@@ -228,8 +1702,82 @@ int main()
     printf("A tac %s\n", search(table, "tac"));
     printf("A dog %s\n", search(table, "dog"));
 
-    printf("cat: %d\n", hash("cat", 151, 53));
-    printf("tac: %d\n", hash("cat", 151, 53));
+    // push the table through a few incremental resizes, up and back down
+    char key[32];
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        insert(table, key, key);
+    }
+    printf("key-4242 %s, count: %zu, size: %zu\n", search(table, "key-4242"), table->count, table->size);
+    const char *batch_keys[] = {"cat", "key-1", "mouse", "key-9999", "dog"};
+    char *batch_values[5];
+    search_batch(table, batch_keys, 5, batch_values);
+    for (int i = 0; i < 5; i++)
+        printf("%s %s%s", batch_keys[i], batch_values[i], i == 4 ? "\n" : ", ");
+    for (int i = 0; i < 20000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        search(table, key);
+    }
+    hash_table_stats_dump(table, stdout);
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        delete(table, key);
+    }
+    printf("key-4242 %s, count: %zu, size: %zu\n", search(table, "key-4242"), table->count, table->size);
+    printf("arena used: %zu, dead: %zu\n", table->arena_used, table->arena_dead);
+    printf("compaction reclaimed %zu bytes\n", compact_hash_table(table));
+    printf("A dog %s\n", search(table, "dog"));
+
+    // save the table and serve it back from the mapped file
+    if (hash_table_save(table, "hash_table.snapshot") == 0)
+    {
+        MappedHashTable *mapped = hash_table_open_mmap("hash_table.snapshot");
+        if (mapped != NULL)
+        {
+            printf("snapshot checksum ok: %d\n", hash_table_verify_mmap(mapped));
+            printf("mapped cat %s, mapped tac %s\n", mapped_search(mapped, "cat"), mapped_search(mapped, "tac"));
+            hash_table_close_mmap(mapped);
+        }
+        remove("hash_table.snapshot");
+    }
+
+    // freeze the table, lookups no longer probe
+    FrozenHashTable *frozen = hash_table_freeze(table);
+    if (frozen != NULL)
+    {
+        printf("frozen cat %s, frozen tac %s, frozen mouse %s\n", frozen_search(frozen, "cat"),
+               frozen_search(frozen, "tac"), frozen_search(frozen, "mouse"));
+        delete_frozen_table(frozen);
+    }
+
+    // missing keys against frozen tables of every size up to 344 keys, none may be found
+    size_t misses_found = 0;
+    for (int size = 1; size <= 344; size++)
+    {
+        HashTable *small = INITIALIZE_HASHTABLE();
+        for (int i = 0; small != NULL && i < size; i++)
+        {
+            snprintf(key, sizeof(key), "key-%d", i);
+            insert(small, key, key);
+        }
+        frozen = small != NULL ? hash_table_freeze(small) : NULL;
+        for (int i = 0; frozen != NULL && i < 2000; i++)
+        {
+            snprintf(key, sizeof(key), "missing-%d", i);
+            misses_found += frozen_search(frozen, key) != NULL;
+        }
+        if (frozen != NULL)
+            delete_frozen_table(frozen);
+        if (small != NULL)
+            delete_hash_table(small);
+    }
+    printf("missing keys found in frozen tables: %zu\n", misses_found);
+
+    printf("cat: %016llx\n", (unsigned long long)hash("cat", 3, table->seed));
+    printf("tac: %016llx\n", (unsigned long long)hash("tac", 3, table->seed));
     delete_hash_table(table);
     return (0);
 }
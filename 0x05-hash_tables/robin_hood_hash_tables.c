@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/*
+ * Robin Hood flavor of the open addressed hash table
+ * Items are probed linearly, and an insert that meets an item closer to its
+ * home bucket than the new item is to its own takes that bucket and carries
+ * on inserting the displaced item instead ("take from the rich"). This keeps
+ * every probe length close to the average, and lets a search stop as soon as
+ * it meets an item closer to home than it is.
+ * Deleting shifts the following items of the cluster one bucket back instead of
+ * leaving a DELETED_ITEM tombstone, so the table never fills up with tombstones
+ * and lookups cost the same after weeks of inserts and deletes as on day one.
+ */
+
+#define INITIAL_SIZE 64
+// percentage of the buckets in use at which the table doubles, Robin Hood copes well with high loads
+#define MAX_LOAD 85
+
+/*
+ * HashTableItem - an item in a hashtable (also called a bucket)
+ * @key: the key of that item
+ * @value: the value under @key
+ */
+typedef struct HashTableItem {
+    char *key;
+    char *value;
+}Ht_item;
+
+/*
+ * Bucket - a slot of the table
+ * @hash: hash of the key of @item, its low bits are the home bucket of the item
+ * so the probe distance of a bucket is known without touching the item
+ * @item: the item or NULL for an empty bucket
+ */
+typedef struct Bucket {
+    uint64_t hash;
+    Ht_item *item;
+} Bucket;
+
+/*
+ * HashTable - our Robin Hood hash table data structure
+ * @size: the number of buckets, a power of two
+ * @count: how full the hash table is
+ * @seed: random per table seed of the hash function
+ * @buckets: the buckets
+ */
+typedef struct HashTable {
+    size_t size;
+    size_t count;
+    uint64_t seed;
+    Bucket *buckets;
+} HashTable;
+
+// odd 64 bit constants of the wyhash family, each one has half of its bits set
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+
+/**
+ * hash_mix - multiplies two 64 bit words into 128 bits and folds the halves together
+ * @a: first word
+ * @b: second word
+ * Return: the low half xor the high half of a * b
+*/
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    __uint128_t product = (__uint128_t)a * b;
+    return ((uint64_t)product ^ (uint64_t)(product >> 64));
+}
+
+/**
+ * read_word - reads 8 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_word(const unsigned char *p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return (word);
+}
+
+/**
+ * read_half - reads 4 bytes of a key in one go
+ * @p: where to read from, no alignment needed
+ * Return: the bytes as a 64 bit word
+*/
+static inline uint64_t read_half(const unsigned char *p)
+{
+    uint32_t half;
+    memcpy(&half, p, sizeof(half));
+    return (half);
+}
+
+/**
+ * hash - the hashing function (a wyhash style hash)
+ * @key_string: the key being hashed
+ * @len: the length of @key_string
+ * @seed: the seed of the table, different seeds give unrelated hashes
+ * Return: a 64 bit hash of @key_string
+ * Description: the key is consumed 16 bytes at a time, every 16 bytes cost one
+ * 64x64->128 bit multiply. The last 1 to 16 bytes are read with (possibly
+ * overlapping) word reads instead of a byte loop.
+*/
+static uint64_t hash(const char *key_string, size_t len, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char *)key_string;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            // first and last 4 bytes of each half, overlapping when len < 16
+            a = (read_half(p) << 32) | read_half(p + ((len >> 3) << 2));
+            b = (read_half(p + len - 4) << 32) | read_half(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+        }
+    } else {
+        size_t i = len;
+        while (i > 16)
+        {
+            seed = hash_mix(read_word(p) ^ HASH_P1, read_word(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read_word(p + i - 16);
+        b = read_word(p + i - 8);
+    }
+    return (hash_mix(HASH_P1 ^ len, hash_mix(a ^ HASH_P1, b ^ seed ^ HASH_P2)));
+}
+
+
+static Ht_item *INITIALIZE_HASH_TABLE_ITEM(const char *key, const char *value)
+{
+    Ht_item *new_item = malloc(sizeof(Ht_item));
+    if (new_item == NULL)
+        return (NULL);
+    new_item -> key = strdup(key);
+    new_item -> value = strdup(value);
+    return (new_item);
+}
+
+/**
+ * random_seed - gets a seed for the hash function of a new table
+ * Return: 64 random bits from the OS, or bits of the clock and the stack
+ * address if the OS has none to give
+*/
+static uint64_t random_seed(void)
+{
+    uint64_t seed;
+    if (getentropy(&seed, sizeof(seed)) == 0)
+        return (seed);
+    seed = (uint64_t)(uintptr_t)&seed;
+    return (seed ^ ((uint64_t)time(NULL) << 32));
+}
+
+/*
+ * INITIALIZE_HASHTABLE - creates a new Robin Hood hash table data structure
+ * Return: the created hash table or null on failure
+ */
+static HashTable *INITIALIZE_HASHTABLE()
+{
+    HashTable *new_hashtable = malloc(sizeof(HashTable));
+    if (new_hashtable == NULL)
+        return (NULL);
+    new_hashtable -> size = INITIAL_SIZE;
+    new_hashtable -> count = 0;
+    new_hashtable -> seed = random_seed();
+    new_hashtable -> buckets = calloc(INITIAL_SIZE, sizeof(Bucket));
+    if (new_hashtable -> buckets == NULL)
+    {
+        free(new_hashtable);
+        return (NULL);
+    }
+    return (new_hashtable);
+}
+
+/**
+ * delete_ht_item - deletes a hash table item which frees the memory thus avoiding memory leaks
+ * @item: the item to be deleted
+*/
+static void delete_ht_item(Ht_item *item)
+{
+    free(item -> key);
+    free(item -> value);
+    free(item);
+}
+
+/**
+ * delete_hash_table - deletes a hash table structure which frees the memory thus avoiding leaks
+ * @table: the table to be deleted
+*/
+static void delete_hash_table(HashTable *table)
+{
+    for (size_t i = 0; i < table->size; i++)
+    {
+        if (table->buckets[i].item != NULL)
+            delete_ht_item(table->buckets[i].item);
+    }
+    free(table -> buckets);
+    free(table);
+}
+
+/**
+ * probe_distance - how far a bucket's item sits from its home bucket
+ * @table: the table
+ * @index: the bucket the item is in
+ * @key_hash: the hash of the item's key
+ * Return: the number of buckets between the home bucket and @index
+*/
+static inline size_t probe_distance(const HashTable *table, size_t index, uint64_t key_hash)
+{
+    const size_t mask = table->size - 1;
+    return ((index - (size_t)(key_hash & mask)) & mask);
+}
+
+/**
+ * find_index - finds the bucket holding key
+ * @table: the table being probed
+ * @key: the key we are looking for
+ * @key_hash: the hash of @key
+ * Return: the index of the bucket or -1 if the key is not in the table
+ * Description: the probe stops at an empty bucket, or at an item closer to its
+ * home than we are to ours. Had @key been in the table, inserting it would have
+ * taken that item's bucket.
+*/
+static long find_index(const HashTable *table, const char *key, uint64_t key_hash)
+{
+    const size_t mask = table->size - 1;
+    size_t index = (size_t)(key_hash & mask);
+    for (size_t distance = 0; ; distance++)
+    {
+        const Bucket *bucket = &table->buckets[index];
+        if (bucket->item == NULL || probe_distance(table, index, bucket->hash) < distance)
+            return (-1);
+        if (bucket->hash == key_hash && strcmp(bucket->item->key, key) == 0)
+            return ((long)index);
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * place_item - Robin Hood insertion of an item that is not in the table yet
+ * @table: the table receiving the item
+ * @item: the item
+ * @key_hash: the hash of the item's key
+ * Description: walking from the home bucket, whenever the item being carried is
+ * further from home than the resident item, they swap places and we carry on
+ * with the resident one
+*/
+static void place_item(HashTable *table, Ht_item *item, uint64_t key_hash)
+{
+    const size_t mask = table->size - 1;
+    size_t index = (size_t)(key_hash & mask);
+    Bucket carried = {key_hash, item};
+    for (size_t distance = 0; ; distance++)
+    {
+        Bucket *bucket = &table->buckets[index];
+        if (bucket->item == NULL)
+        {
+            *bucket = carried;
+            return;
+        }
+        const size_t resident_distance = probe_distance(table, index, bucket->hash);
+        if (resident_distance < distance)
+        {
+            Bucket resident = *bucket;
+            *bucket = carried;
+            carried = resident;
+            distance = resident_distance;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * resize - rehashes every item into a table of @new_size buckets
+ * @table: the table being resized
+ * @new_size: the new number of buckets, a power of two
+ * Return: 0 on success or -1 on failure (the table is left untouched)
+*/
+static int resize(HashTable *table, size_t new_size)
+{
+    Bucket *old_buckets = table->buckets;
+    const size_t old_size = table->size;
+    Bucket *buckets = calloc(new_size, sizeof(Bucket));
+    if (buckets == NULL)
+        return (-1);
+    table->buckets = buckets;
+    table->size = new_size;
+    for (size_t i = 0; i < old_size; i++)
+    {
+        if (old_buckets[i].item != NULL)
+            place_item(table, old_buckets[i].item, old_buckets[i].hash);
+    }
+    free(old_buckets);
+    return (0);
+}
+
+/**
+ * insert - inserts a key and a value (a bucket) to a given hash table
+ * @table: the table to which we are inserting the key value pair
+ * @key: the key of a bucket
+ * @value: value associated to a certain bucket
+ * Description: if @key is already present its value is replaced
+*/
+void insert(HashTable *table, const char *key, const char *value)
+{
+    const uint64_t key_hash = hash(key, strlen(key), table->seed);
+    long index = find_index(table, key, key_hash);
+    if (index >= 0)
+    {
+        char *new_value = strdup(value);
+        if (new_value == NULL)
+            return;
+        free(table->buckets[index].item->value);
+        table->buckets[index].item->value = new_value;
+        return;
+    }
+    if ((table->count + 1) * 100 > table->size * MAX_LOAD && resize(table, table->size * 2) != 0)
+        return;
+    Ht_item *new_item = INITIALIZE_HASH_TABLE_ITEM(key, value);
+    if (new_item == NULL)
+        return;
+    place_item(table, new_item, key_hash);
+    table->count++;
+}
+
+/**
+ * search - tries to locate a value given a key
+ * @table: the table from which we try to locate the value
+ * @key: the key to use for searching
+ * Return: the found value associated with key or NULL if no item is found
+*/
+char *search(HashTable *table, const char *key)
+{
+    long index = find_index(table, key, hash(key, strlen(key), table->seed));
+    if (index < 0)
+        return (NULL);
+    return (table->buckets[index].item->value);
+}
+
+/**
+ * delete - deletes an item from a hash table
+ * @table: the table from which we are deleting from
+ * @key: the key of the bucket to delete
+ * Description: backward shift deletion, the items following the deleted one
+ * move one bucket back (closer to home) until we meet an empty bucket or an
+ * item already in its home bucket. The table is then exactly as if the deleted
+ * item had never been inserted, no tombstone is left behind.
+*/
+void delete(HashTable *table, const char *key)
+{
+    long found = find_index(table, key, hash(key, strlen(key), table->seed));
+    if (found < 0)
+        return;
+    const size_t mask = table->size - 1;
+    size_t index = (size_t)found;
+    delete_ht_item(table->buckets[index].item);
+    size_t next = (index + 1) & mask;
+    while (table->buckets[next].item != NULL && probe_distance(table, next, table->buckets[next].hash) > 0)
+    {
+        table->buckets[index] = table->buckets[next];
+        index = next;
+        next = (next + 1) & mask;
+    }
+    table->buckets[index].item = NULL;
+    table->buckets[index].hash = 0;
+    table->count--;
+}
+
+/**
+ * print_probe_lengths - prints the average and longest probe distance of the table
+ * @table: the table
+*/
+static void print_probe_lengths(const HashTable *table)
+{
+    size_t total = 0;
+    size_t longest = 0;
+    for (size_t i = 0; i < table->size; i++)
+    {
+        if (table->buckets[i].item == NULL)
+            continue;
+        const size_t distance = probe_distance(table, i, table->buckets[i].hash);
+        total += distance;
+        if (distance > longest)
+            longest = distance;
+    }
+    printf("count: %zu, size: %zu, average probe: %.2f, longest probe: %zu\n", table->count,
+           table->size, table->count ? (double)total / table->count : 0.0, longest);
+}
+
+int main()
+{
+    printf("Robin Hood hash tables\n");
+    HashTable *table = INITIALIZE_HASHTABLE();
+    if (table == NULL)
+        return (1);
+    insert(table, "cat", "meows");
+    insert(table, "tac", "weoms");
+    insert(table, "dog", "barks");
+    printf("A cat %s\n", search(table, "cat"));
+    printf("A tac %s\n", search(table, "tac"));
+    printf("A dog %s\n", search(table, "dog"));
+    delete(table, "tac");
+    printf("A tac %s\n", search(table, "tac"));
+
+    // churn: the probe lengths after a million deletes and inserts are those of a fresh table
+    char key[32];
+    for (int i = 0; i < 50000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        insert(table, key, key);
+    }
+    print_probe_lengths(table);
+    for (int i = 0; i < 1000000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        delete(table, key);
+        snprintf(key, sizeof(key), "key-%d", i + 50000);
+        insert(table, key, key);
+    }
+    print_probe_lengths(table);
+    printf("key-1049999 %s\n", search(table, "key-1049999"));
+    printf("key-999999 %s\n", search(table, "key-999999"));
+    delete_hash_table(table);
+    return (0);
+}
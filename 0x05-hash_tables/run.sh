@@ -1,7 +1,6 @@
 #!/bin/bash
 
-# -lm flag will make the inbuilt math.h header file to work
-# without this flag, the math.h header file might not work
-gcc hash_tables.c -o a -lm
+# pass the file to build, defaults to hash_tables.c
+# e.g ./run.sh swiss_hash_tables.c
+gcc ${1:-hash_tables.c} -o a
 ./a
-
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+/*
+ * Another flavor of the open addressed hash table (Swiss table style)
+ * Next to the array of item pointers we keep an array of one byte control tags,
+ * one per slot. A tag is either EMPTY, DELETED or the low 7 bits of the key's hash.
+ * Slots are probed in groups of 16, all the tags of a group are compared against
+ * the wanted tag at once (a single SSE2 compare) so we only dereference items
+ * and call strcmp on slots whose 7 bit tag already matches.
+ */
+
+#define GROUP_WIDTH 16
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+/*
+ * HashTableItem - an item in a hashtable (also called a bucket)
+ * @key: the key of that item
+ * @value: the value under @key
+ */
+typedef struct HashTableItem {
+    char *key;
+    char *value;
+}Ht_item;
+
+/*
+ * HashTable - the swiss flavor of our hash table data structure
+ * @size: number of slots, always a power of two multiple of GROUP_WIDTH
+ * @count: number of live items in the table
+ * @deleted: number of slots whose control tag is CTRL_DELETED
+ * @ctrl: one control tag per slot, EMPTY, DELETED or 7 bits of the hash
+ * @items: an array of pointers to hash table items, parallel to @ctrl
+ */
+typedef struct HashTable {
+    size_t size;
+    size_t count;
+    size_t deleted;
+    uint8_t *ctrl;
+    Ht_item **items;
+} HashTable;
+
+static Ht_item *INITIALIZE_HASH_TABLE_ITEM(const char *key, const char *value)
+{
+    Ht_item *new_item = malloc(sizeof(Ht_item));
+    if (new_item == NULL)
+        return (NULL);
+    new_item -> key = strdup(key);
+    new_item -> value = strdup(value);
+    return (new_item);
+}
+
+/**
+ * allocate_slots - allocates the control tags and item slots of a table
+ * @table: the table whose slot arrays are being allocated
+ * @size: number of slots, a power of two multiple of GROUP_WIDTH
+ * Return: 0 on success or -1 on failure
+*/
+static int allocate_slots(HashTable *table, size_t size)
+{
+    uint8_t *ctrl = malloc(size);
+    Ht_item **items = calloc(size, sizeof(Ht_item *));
+    if (ctrl == NULL || items == NULL)
+    {
+        free(ctrl);
+        free(items);
+        return (-1);
+    }
+    memset(ctrl, CTRL_EMPTY, size);
+    table->size = size;
+    table->ctrl = ctrl;
+    table->items = items;
+    return (0);
+}
+
+/*
+ * INITIALIZE_HASHTABLE - creates a new swiss hash table data structure
+ * Return: the created hash table or null on failure
+ */
+static HashTable *INITIALIZE_HASHTABLE()
+{
+    HashTable *new_hashtable = malloc(sizeof(HashTable));
+    if (new_hashtable == NULL)
+        return (NULL);
+    new_hashtable -> count = 0;
+    new_hashtable -> deleted = 0;
+    if (allocate_slots(new_hashtable, 4 * GROUP_WIDTH) != 0)
+    {
+        free(new_hashtable);
+        return (NULL);
+    }
+    return (new_hashtable);
+}
+
+/**
+ * delete_ht_item - deletes a hash table item which frees the memory thus avoiding memory leaks
+ * @item: the item to be deleted
+*/
+static void delete_ht_item(Ht_item *item)
+{
+    free(item -> key);
+    free(item -> value);
+    free(item);
+}
+
+/**
+ * delete_hash_table - deletes a hash table structure which frees the memory thus avoiding leaks
+ * @table: the table to be deleted
+*/
+static void delete_hash_table(HashTable *table)
+{
+    for (size_t i = 0; i < table->size; i++)
+    {
+        if (table->ctrl[i] < CTRL_EMPTY)
+            delete_ht_item(table->items[i]);
+    }
+    free(table -> ctrl);
+    free(table -> items);
+    free(table);
+}
+
+/**
+ * hash - 64 bit FNV-1a hash of a string
+ * @key_string: the string being hashed
+ * Return: the full 64 bit hash, the high bits pick the group to start probing
+ * and the low 7 bits become the control tag of the slot
+*/
+static uint64_t hash(const char *key_string)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)key_string; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return (hash);
+}
+
+/**
+ * match_byte - finds the slots of a group whose control tag equals @tag
+ * @ctrl: the first control tag of the group
+ * @tag: the tag we are looking for
+ * Return: a bit mask with bit i set when slot i of the group matches
+ * Description: with SSE2 this is one 16 byte compare and a movemask,
+ * otherwise we fall back to checking the 16 tags one by one
+*/
+static inline uint32_t match_byte(const uint8_t *ctrl, uint8_t tag)
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++)
+        if (ctrl[i] == tag)
+            mask |= 1u << i;
+    return (mask);
+#endif
+}
+
+/**
+ * match_free - finds the slots of a group that are EMPTY or DELETED
+ * @ctrl: the first control tag of the group
+ * Return: a bit mask with bit i set when slot i of the group can take a new item
+ * Description: free tags are exactly the ones with the high bit set,
+ * so SSE2 can get them straight from movemask
+*/
+static inline uint32_t match_free(const uint8_t *ctrl)
+{
+#ifdef __SSE2__
+    return ((uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++)
+        if (ctrl[i] & 0x80)
+            mask |= 1u << i;
+    return (mask);
+#endif
+}
+
+/**
+ * find_slot - locates the slot holding @key
+ * @table: the table being probed
+ * @key: the key we are looking for
+ * @key_hash: hash(key)
+ * Return: the slot index or -1 if the key is not in the table
+ * Description: groups are visited in triangular order (g, g+1, g+3, g+6, ...),
+ * which reaches every group since the number of groups is a power of two.
+ * The first group with an EMPTY slot ends the probe.
+*/
+static long find_slot(const HashTable *table, const char *key, uint64_t key_hash)
+{
+    const size_t group_mask = table->size / GROUP_WIDTH - 1;
+    const uint8_t tag = (uint8_t)(key_hash & 0x7F);
+    size_t group = (size_t)(key_hash >> 7) & group_mask;
+    for (size_t i = 1; i <= group_mask + 1; i++)
+    {
+        const size_t base = group * GROUP_WIDTH;
+        uint32_t candidates = match_byte(table->ctrl + base, tag);
+        while (candidates)
+        {
+            const size_t index = base + (size_t)__builtin_ctz(candidates);
+            if (strcmp(table->items[index]->key, key) == 0)
+                return ((long)index);
+            candidates &= candidates - 1;
+        }
+        if (match_byte(table->ctrl + base, CTRL_EMPTY))
+            return (-1);
+        group = (group + i) & group_mask;
+    }
+    return (-1);
+}
+
+/**
+ * place_item - puts an item in the first free slot of its probe sequence
+ * @table: the table receiving the item
+ * @item: the item, which must not already be in the table
+ * @key_hash: hash(item->key)
+ * Return: the slot the item was stored at
+*/
+static size_t place_item(HashTable *table, Ht_item *item, uint64_t key_hash)
+{
+    const size_t group_mask = table->size / GROUP_WIDTH - 1;
+    size_t group = (size_t)(key_hash >> 7) & group_mask;
+    size_t i = 1;
+    uint32_t free_slots;
+    while ((free_slots = match_free(table->ctrl + group * GROUP_WIDTH)) == 0)
+    {
+        group = (group + i) & group_mask;
+        i++;
+    }
+    const size_t index = group * GROUP_WIDTH + (size_t)__builtin_ctz(free_slots);
+    if (table->ctrl[index] == CTRL_DELETED)
+        table->deleted--;
+    table->ctrl[index] = (uint8_t)(key_hash & 0x7F);
+    table->items[index] = item;
+    return (index);
+}
+
+/**
+ * resize - rehashes every live item into a table of @new_size slots
+ * @table: the table being resized
+ * @new_size: the new number of slots
+ * Return: 0 on success or -1 on failure (the table is left untouched)
+ * Description: dropping DELETED tags is a side effect, so this is also
+ * how tombstones get cleaned up when they pile up
+*/
+static int resize(HashTable *table, size_t new_size)
+{
+    const size_t old_size = table->size;
+    uint8_t *old_ctrl = table->ctrl;
+    Ht_item **old_items = table->items;
+    if (allocate_slots(table, new_size) != 0)
+        return (-1);
+    table->deleted = 0;
+    for (size_t i = 0; i < old_size; i++)
+    {
+        if (old_ctrl[i] < CTRL_EMPTY)
+            place_item(table, old_items[i], hash(old_items[i]->key));
+    }
+    free(old_ctrl);
+    free(old_items);
+    return (0);
+}
+
+/**
+ * insert - inserts a key and a value (a bucket) to a given hash table
+ * @table: the table to which we are inserting the key value pair
+ * @key: the key of a bucket
+ * @value: value associated to a certain bucket
+ * Description: if @key is already present its value is replaced. The table
+ * grows once live plus deleted slots reach 7/8 of its size.
+*/
+void insert(HashTable *table, const char *key, const char *value)
+{
+    const uint64_t key_hash = hash(key);
+    long index = find_slot(table, key, key_hash);
+    if (index >= 0)
+    {
+        char *new_value = strdup(value);
+        if (new_value == NULL)
+            return;
+        free(table->items[index]->value);
+        table->items[index]->value = new_value;
+        return;
+    }
+    if ((table->count + table->deleted + 1) * 8 > table->size * 7)
+    {
+        // only grow if live items need the room, otherwise rehashing in place clears the tombstones
+        size_t new_size = table->size;
+        if ((table->count + 1) * 2 > table->size)
+            new_size *= 2;
+        if (resize(table, new_size) != 0)
+            return;
+    }
+    Ht_item *new_item = INITIALIZE_HASH_TABLE_ITEM(key, value);
+    if (new_item == NULL)
+        return;
+    place_item(table, new_item, key_hash);
+    table->count++;
+}
+
+/**
+ * search - tries to locate a value given a key
+ * @table: the table from which we try to locate the value
+ * @key: the key to use for searching
+ * Return: the found value associated with key or NULL if no item is found
+*/
+char *search(HashTable *table, const char *key)
+{
+    long index = find_slot(table, key, hash(key));
+    if (index < 0)
+        return (NULL);
+    return (table->items[index]->value);
+}
+
+/**
+ * delete - deletes an item from a hash table
+ * @table: the table from which we are deleting from
+ * @key: the key of the bucket to delete
+ * Description: if the group of the deleted slot still has an EMPTY slot no probe
+ * sequence can have gone past this group, so the slot goes straight back to EMPTY.
+ * Only slots in full groups become DELETED tombstones.
+*/
+void delete(HashTable *table, const char *key)
+{
+    long index = find_slot(table, key, hash(key));
+    if (index < 0)
+        return;
+    const size_t base = (size_t)index & ~(size_t)(GROUP_WIDTH - 1);
+    delete_ht_item(table->items[index]);
+    table->items[index] = NULL;
+    if (match_byte(table->ctrl + base, CTRL_EMPTY))
+    {
+        table->ctrl[index] = CTRL_EMPTY;
+    } else {
+        table->ctrl[index] = CTRL_DELETED;
+        table->deleted++;
+    }
+    table->count--;
+}
+
+int main()
+{
+    printf("Swiss hash tables\n");
+    HashTable *table = INITIALIZE_HASHTABLE();
+    if (table == NULL)
+        return (1);
+    insert(table, "cat", "meows");
+    insert(table, "tac", "weoms");
+    insert(table, "dog", "barks");
+    printf("A cat %s\n", search(table, "cat"));
+    printf("A tac %s\n", search(table, "tac"));
+    printf("A dog %s\n", search(table, "dog"));
+
+    // push the table through a few resizes
+    char key[32];
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        insert(table, key, key);
+    }
+    for (int i = 0; i < 10000; i += 2)
+    {
+        snprintf(key, sizeof(key), "key-%d", i);
+        delete(table, key);
+    }
+    delete(table, "tac");
+    printf("A tac %s\n", search(table, "tac"));
+    printf("key-4241 %s\n", search(table, "key-4241"));
+    printf("key-4242 %s\n", search(table, "key-4242"));
+    printf("count: %zu, size: %zu\n", table->count, table->size);
+    delete_hash_table(table);
+    return (0);
+}
@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * A cache conscious alternative to the BST: a B+ tree of ints
+ * Every BSTNode holds one value, so a lookup pays a cache miss per level of a
+ * tree log2(n) high. Here a node holds up to NODE_KEYS keys, which fill exactly
+ * one cache line, so a million keys make a tree 6 levels high instead of 20.
+ * The keys of a node are compared against the wanted key all at once with
+ * AVX2 (or SSE2) compares instead of a branchy loop, which reads that one line.
+ * Going down a level reads one more line for the child pointer. A leaf is the
+ * key line plus a line for its count and next pointer (128 bytes), an inner
+ * node the key line plus its count and NODE_KEYS + 1 children (256 bytes).
+ * Values only live in the leaves, which are linked left to right, so an in-order
+ * or range traversal is a walk along the leaves.
+ */
+
+// keys per node, 16 ints are one 64 byte cache line
+#define NODE_KEYS 16
+#define CACHE_LINE 64
+
+/**
+ * BPlusNode - an inner node of the B+ tree
+ * @keys: the keys, sorted, slots past @count hold INT_MAX
+ * @count: number of keys in use
+ * @children: child i holds the keys below keys[i] and at or above keys[i - 1],
+ * so there are @count + 1 children. They are BPlusLeafs on the level above the
+ * leaves, stored as BPlusNode pointers since both start with @keys and @count
+*/
+typedef struct BPlusNode {
+    int keys[NODE_KEYS];
+    int count;
+    struct BPlusNode *children[NODE_KEYS + 1];
+} __attribute__((aligned(CACHE_LINE))) BPlusNode;
+
+/**
+ * BPlusLeaf - a leaf of the B+ tree
+ * @keys: the keys, sorted, slots past @count hold INT_MAX
+ * @count: number of keys in use
+ * @next: the leaf holding the next keys in order
+*/
+typedef struct BPlusLeaf {
+    int keys[NODE_KEYS];
+    int count;
+    struct BPlusLeaf *next;
+} __attribute__((aligned(CACHE_LINE))) BPlusLeaf;
+
+/**
+ * BPlusTree - a B+ tree
+ * @root: the root node, a BPlusLeaf when @height is 1, NULL for an empty tree
+ * @height: number of levels, the nodes on the last level are the leaves
+ * @count: number of keys in the tree
+ * @spare_leaf: a leaf allocated ahead of the insert that may need it
+ * @spare_nodes: inner nodes allocated ahead of the inserts that may need them,
+ * chained through children[0]
+ * @spare_count: number of nodes in @spare_nodes
+ * Description: an insert splits at most one leaf and one inner node per level,
+ * plus a new root. Those nodes are allocated before the insert changes anything,
+ * so running out of memory never leaves a split half done
+*/
+typedef struct BPlusTree {
+    BPlusNode *root;
+    int height;
+    size_t count;
+    BPlusLeaf *spare_leaf;
+    BPlusNode *spare_nodes;
+    int spare_count;
+} BPlusTree;
+
+/**
+ * as_leaf - views a node of the last level as the leaf it is
+ * @node: the node
+ * Return: the leaf
+*/
+static inline BPlusLeaf *as_leaf(BPlusNode *node)
+{
+    return ((BPlusLeaf *)node);
+}
+
+/**
+ * INITIALIZE_NODE - allocates an empty cache line aligned inner node
+ * Return: the node or NULL on failure
+*/
+static BPlusNode *INITIALIZE_NODE(void)
+{
+    BPlusNode *new_node = aligned_alloc(CACHE_LINE, sizeof(BPlusNode));
+    if (new_node == NULL) return NULL;
+    for (int i = 0; i < NODE_KEYS; i++)
+        new_node->keys[i] = INT_MAX;
+    new_node->count = 0;
+    memset(new_node->children, 0, sizeof(new_node->children));
+    return (new_node);
+}
+
+/**
+ * INITIALIZE_LEAF - allocates an empty cache line aligned leaf
+ * Return: the leaf or NULL on failure
+*/
+static BPlusLeaf *INITIALIZE_LEAF(void)
+{
+    BPlusLeaf *new_leaf = aligned_alloc(CACHE_LINE, sizeof(BPlusLeaf));
+    if (new_leaf == NULL) return NULL;
+    for (int i = 0; i < NODE_KEYS; i++)
+        new_leaf->keys[i] = INT_MAX;
+    new_leaf->count = 0;
+    new_leaf->next = NULL;
+    return (new_leaf);
+}
+
+/**
+ * reserve_nodes - allocates the nodes the next insert may need
+ * @tree: the tree
+ * Return: true on success, false if memory ran out (the tree is unchanged)
+*/
+static bool reserve_nodes(BPlusTree *tree)
+{
+    if (tree->spare_leaf == NULL)
+    {
+        tree->spare_leaf = INITIALIZE_LEAF();
+        if (tree->spare_leaf == NULL)
+            return (false);
+    }
+    // one split per inner level, and a new root when the root splits
+    while (tree->spare_count < tree->height)
+    {
+        BPlusNode *node = INITIALIZE_NODE();
+        if (node == NULL)
+            return (false);
+        node->children[0] = tree->spare_nodes;
+        tree->spare_nodes = node;
+        tree->spare_count++;
+    }
+    return (true);
+}
+
+/**
+ * take_leaf - hands out the spare leaf
+ * @tree: the tree, reserve_nodes must have run since the last take_leaf
+ * Return: the leaf
+*/
+static BPlusLeaf *take_leaf(BPlusTree *tree)
+{
+    BPlusLeaf *leaf = tree->spare_leaf;
+    tree->spare_leaf = NULL;
+    return (leaf);
+}
+
+/**
+ * take_node - hands out a spare inner node
+ * @tree: the tree, reserve_nodes must have left a node for this call
+ * Return: the node
+*/
+static BPlusNode *take_node(BPlusTree *tree)
+{
+    BPlusNode *node = tree->spare_nodes;
+    tree->spare_nodes = node->children[0];
+    tree->spare_count--;
+    node->children[0] = NULL;
+    return (node);
+}
+
+/**
+ * node_rank - counts the keys of a node that are less than or equal to a value
+ * @node: the node, or a leaf viewed as one
+ * @value: the value
+ * Return: the count, which for an inner node is the child to go down to
+ * and for a leaf is one past where value is (or would be)
+ * Description: all NODE_KEYS slots are compared at once, 2 compares with AVX2
+ * or 4 with SSE2, and the answer is the number of keys not greater than value.
+ * Unused slots hold INT_MAX so they are never counted, except for INT_MAX
+ * itself which is why the result is capped at count.
+*/
+static inline int node_rank(const BPlusNode *node, int value)
+{
+    int greater;
+#ifdef __AVX2__
+    const __m256i wanted = _mm256_set1_epi32(value);
+    const __m256i low = _mm256_load_si256((const __m256i *)node->keys);
+    const __m256i high = _mm256_load_si256((const __m256i *)(node->keys + 8));
+    const unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(low, wanted))) |
+                              ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(high, wanted))) << 8);
+    greater = __builtin_popcount(mask);
+#elif defined(__SSE2__)
+    const __m128i wanted = _mm_set1_epi32(value);
+    unsigned int mask = 0;
+    for (int i = 0; i < NODE_KEYS / 4; i++)
+    {
+        const __m128i keys = _mm_load_si128((const __m128i *)(node->keys + 4 * i));
+        mask |= (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(keys, wanted))) << (4 * i);
+    }
+    greater = __builtin_popcount(mask);
+#else
+    greater = 0;
+    for (int i = 0; i < NODE_KEYS; i++)
+        greater += node->keys[i] > value;
+#endif
+    const int rank = NODE_KEYS - greater;
+    return (rank < node->count ? rank : node->count);
+}
+
+/**
+ * find_leaf - walks down to the leaf a value belongs in
+ * @tree: the tree, not empty
+ * @value: the value
+ * Return: the leaf
+*/
+static BPlusLeaf *find_leaf(const BPlusTree *tree, int value)
+{
+    BPlusNode *node = tree->root;
+    for (int level = 1; level < tree->height; level++)
+        node = node->children[node_rank(node, value)];
+    return (as_leaf(node));
+}
+
+/**
+ * bpt_contains - checks whether a value is in the tree
+ * @tree: the tree
+ * @value: the value to look for
+ * Return: true if it is there, false otherwise
+*/
+static bool bpt_contains(const BPlusTree *tree, int value)
+{
+    if (tree->root == NULL)
+        return (false);
+    const BPlusNode *leaf = (const BPlusNode *)find_leaf(tree, value);
+    const int rank = node_rank(leaf, value);
+    return (rank > 0 && leaf->keys[rank - 1] == value);
+}
+
+/**
+ * insert_key - puts a key (and for inner nodes the child to its right) into a node with room
+ * @keys: the keys of the node, leaf or inner node
+ * @count: the number of keys of the node, < NODE_KEYS, incremented
+ * @children: the children of an inner node, NULL for leaves
+ * @position: where the key goes
+ * @key: the key
+ * @right: the child right of the key, unused for leaves
+*/
+static void insert_key(int *keys, int *count, BPlusNode **children, int position, int key, BPlusNode *right)
+{
+    memmove(&keys[position + 1], &keys[position], (*count - position) * sizeof(int));
+    keys[position] = key;
+    if (children != NULL)
+    {
+        memmove(&children[position + 2], &children[position + 1],
+                (*count - position) * sizeof(BPlusNode *));
+        children[position + 1] = right;
+    }
+    (*count)++;
+}
+
+/**
+ * split_leaf - splits a full leaf while inserting a key into it
+ * @leaf: the full leaf, keeps the lower half
+ * @right: an empty leaf, gets the upper half
+ * @position: where the key goes
+ * @key: the key
+ * Return: the smallest key of @right, the separator for the parent
+*/
+static int split_leaf(BPlusLeaf *leaf, BPlusLeaf *right, int position, int key)
+{
+    int all[NODE_KEYS + 1];
+    memcpy(all, leaf->keys, position * sizeof(int));
+    all[position] = key;
+    memcpy(all + position + 1, leaf->keys + position, (NODE_KEYS - position) * sizeof(int));
+    const int keep = (NODE_KEYS + 1) / 2;
+    for (int i = 0; i < NODE_KEYS; i++)
+        leaf->keys[i] = i < keep ? all[i] : INT_MAX;
+    leaf->count = keep;
+    memcpy(right->keys, all + keep, (NODE_KEYS + 1 - keep) * sizeof(int));
+    right->count = NODE_KEYS + 1 - keep;
+    right->next = leaf->next;
+    leaf->next = right;
+    return (right->keys[0]);
+}
+
+/**
+ * split_inner - splits a full inner node while inserting a key and child into it
+ * @node: the full node, keeps the lower half
+ * @right: an empty node, gets the upper half
+ * @position: where the key goes
+ * @key: the key
+ * @child: the child right of the key
+ * Return: the middle key, which moves up to the parent
+*/
+static int split_inner(BPlusNode *node, BPlusNode *right, int position, int key, BPlusNode *child)
+{
+    int keys[NODE_KEYS + 1];
+    BPlusNode *children[NODE_KEYS + 2];
+    memcpy(keys, node->keys, position * sizeof(int));
+    keys[position] = key;
+    memcpy(keys + position + 1, node->keys + position, (NODE_KEYS - position) * sizeof(int));
+    memcpy(children, node->children, (position + 1) * sizeof(BPlusNode *));
+    children[position + 1] = child;
+    memcpy(children + position + 2, node->children + position + 1, (NODE_KEYS - position) * sizeof(BPlusNode *));
+    const int keep = NODE_KEYS / 2;
+    const int separator = keys[keep];
+    for (int i = 0; i < NODE_KEYS; i++)
+        node->keys[i] = i < keep ? keys[i] : INT_MAX;
+    memcpy(node->children, children, (keep + 1) * sizeof(BPlusNode *));
+    node->count = keep;
+    right->count = NODE_KEYS - keep;
+    memcpy(right->keys, keys + keep + 1, right->count * sizeof(int));
+    memcpy(right->children, children + keep + 1, (right->count + 1) * sizeof(BPlusNode *));
+    return (separator);
+}
+
+/**
+ * insert_into - recursive part of bpt_insert
+ * @tree: the tree, its spare nodes pay for the splits
+ * @node: root of the subtree the value goes into
+ * @level: level of @node, 1 for the root
+ * @value: the value
+ * @separator: gets the separator key when @node had to split
+ * @split: gets the new right sibling when @node had to split, NULL otherwise
+ * Return: 1 if inserted, 0 if the value was already there
+*/
+static int insert_into(BPlusTree *tree, BPlusNode *node, int level, int value, int *separator, BPlusNode **split)
+{
+    const int rank = node_rank(node, value);
+    *split = NULL;
+    if (level == tree->height)
+    {
+        BPlusLeaf *leaf = as_leaf(node);
+        if (rank > 0 && leaf->keys[rank - 1] == value)
+            return (0);
+        if (leaf->count < NODE_KEYS)
+        {
+            insert_key(leaf->keys, &leaf->count, NULL, rank, value, NULL);
+            return (1);
+        }
+        BPlusLeaf *right = take_leaf(tree);
+        *separator = split_leaf(leaf, right, rank, value);
+        *split = (BPlusNode *)right;
+        return (1);
+    }
+    int child_separator;
+    BPlusNode *child_split;
+    const int result = insert_into(tree, node->children[rank], level + 1, value, &child_separator, &child_split);
+    if (child_split == NULL)
+        return (result);
+    if (node->count < NODE_KEYS)
+    {
+        insert_key(node->keys, &node->count, node->children, rank, child_separator, child_split);
+        return (result);
+    }
+    *split = take_node(tree);
+    *separator = split_inner(node, *split, rank, child_separator, child_split);
+    return (result);
+}
+
+/**
+ * bpt_insert - inserts a value into the tree
+ * @tree: the tree
+ * @value: the value to insert
+ * Return: true if inserted, false if it was already in the tree or on failure
+ * Description: like insert_node, duplicates are refused. A full node splits in
+ * two on the way back up, and when the root splits the tree gets a level taller.
+ * On failure the tree is left as it was
+*/
+static bool bpt_insert(BPlusTree *tree, int value)
+{
+    if (!reserve_nodes(tree))
+        return (false);
+    if (tree->root == NULL)
+    {
+        tree->root = (BPlusNode *)take_leaf(tree);
+        tree->height = 1;
+    }
+    int separator;
+    BPlusNode *split;
+    const int result = insert_into(tree, tree->root, 1, value, &separator, &split);
+    if (split != NULL)
+    {
+        BPlusNode *root = take_node(tree);
+        root->keys[0] = separator;
+        root->count = 1;
+        root->children[0] = tree->root;
+        root->children[1] = split;
+        tree->root = root;
+        tree->height++;
+    }
+    if (result == 1)
+        tree->count++;
+    return (result == 1);
+}
+
+/**
+ * bpt_inorder_traversal - calls a function on every value in increasing order
+ * @tree: the tree
+ * @function: function to be called on each value
+ * Description: down the leftmost path once, then along the leaves
+*/
+static void bpt_inorder_traversal(const BPlusTree *tree, void (*function)(int))
+{
+    if (tree->root == NULL) return;
+    BPlusNode *node = tree->root;
+    for (int level = 1; level < tree->height; level++)
+        node = node->children[0];
+    for (const BPlusLeaf *leaf = as_leaf(node); leaf != NULL; leaf = leaf->next)
+        for (int i = 0; i < leaf->count; i++)
+            function(leaf->keys[i]);
+}
+
+/**
+ * bpt_range_traversal - calls a function on every value in [low, high], in increasing order
+ * @tree: the tree
+ * @low: smallest value to visit
+ * @high: largest value to visit
+ * @function: function to be called on each value
+*/
+static void bpt_range_traversal(const BPlusTree *tree, int low, int high, void (*function)(int))
+{
+    if (tree->root == NULL || low > high) return;
+    const BPlusLeaf *leaf = find_leaf(tree, low);
+    // the first key at or above low, low itself when it is in the tree
+    int i = node_rank((const BPlusNode *)leaf, low);
+    if (i > 0 && leaf->keys[i - 1] == low)
+        i--;
+    for (; leaf != NULL; leaf = leaf->next, i = 0)
+        for (; i < leaf->count; i++)
+        {
+            if (leaf->keys[i] > high)
+                return;
+            function(leaf->keys[i]);
+        }
+}
+
+/**
+ * free_nodes - frees a subtree
+ * @node: root of the subtree
+ * @level: level of @node
+ * @height: height of the tree
+*/
+static void free_nodes(BPlusNode *node, int level, int height)
+{
+    if (level < height)
+        for (int i = 0; i <= node->count; i++)
+            free_nodes(node->children[i], level + 1, height);
+    free(node);
+}
+
+/**
+ * bpt_destroy - frees every node of a tree and leaves it empty
+ * @tree: the tree
+*/
+static void bpt_destroy(BPlusTree *tree)
+{
+    if (tree->root != NULL)
+        free_nodes(tree->root, 1, tree->height);
+    free(tree->spare_leaf);
+    while (tree->spare_nodes != NULL)
+        free(take_node(tree));
+    tree->root = NULL;
+    tree->height = 0;
+    tree->count = 0;
+    tree->spare_leaf = NULL;
+}
+
+void print_number(int n)
+{
+    printf("%d ", n);
+}
+
+int main()
+{
+    printf("B+ tree in C\n");
+    BPlusTree tree = {0};
+    const int values[] = {20, 11, 28, 30, 26, 9, 15, 20, 8, 10, 14, 16, 24, 29};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+        bpt_insert(&tree, values[i]);
+    printf("Inorder traversal: ");
+    bpt_inorder_traversal(&tree, &print_number);
+    printf("\nRange [12, 27]: ");
+    bpt_range_traversal(&tree, 12, 27, &print_number);
+    printf("\n20 is %sin the tree, 21 is %sin the tree\n", bpt_contains(&tree, 20) ? "" : "not ",
+           bpt_contains(&tree, 21) ? "" : "not ");
+    bpt_destroy(&tree);
+
+    // a million keys in a scrambled order
+    const int n = 1000000;
+    for (int i = 0; i < n; i++)
+        bpt_insert(&tree, (int)(((long long)i * 7919) % n) * 2);
+    int missing = 0;
+    for (int i = 0; i < 2 * n; i++)
+        missing += bpt_contains(&tree, i) != (i % 2 == 0);
+    printf("%zu keys, height %d, %d wrong lookups\n", tree.count, tree.height, missing);
+    printf("Range [1999980, 2000000]: ");
+    bpt_range_traversal(&tree, 1999980, 2000000, &print_number);
+    printf("\n");
+    bpt_destroy(&tree);
+    return (0);
+}
@@ -2,56 +2,149 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
 
+/**
+ * BSTNode - a node of the binary search tree
+ * @data: the value held by the node
+ * @height: number of nodes on the longest path from this node down to a leaf,
+ * only kept up to date by the avl_ functions
+ * @size: number of nodes in the subtree rooted here, kept up to date by every
+ * function that changes the tree
+ * @left: subtree of the values smaller than @data
+ * @right: subtree of the values greater than @data
+*/
 typedef struct BSTNode {
     int data;
+    int height;
+    size_t size;
     struct BSTNode *left;
     struct BSTNode *right;
 } BSTNode;
 
+// bytes of a slab nodes are carved out of
+#define SLAB_SIZE (64 * 1024)
+
+/**
+ * NodeSlab - a block of memory nodes are carved out of
+ * @next: the slab allocated before this one
+ * @nodes: the nodes themselves
+*/
+typedef struct NodeSlab {
+    struct NodeSlab *next;
+    BSTNode nodes[];
+} NodeSlab;
+
+#define SLAB_NODES ((SLAB_SIZE - sizeof(NodeSlab)) / sizeof(BSTNode))
+
+/**
+ * BST - a binary search tree and the memory its nodes live in
+ * @root: the root node, NULL for an empty tree
+ * @slabs: the slabs of the tree, newest first
+ * @slab_used: nodes handed out of the newest slab so far
+ * @free_nodes: nodes deleted from the tree, chained through their left pointer,
+ * handed out again before any new slab memory
+ * Description: a zeroed BST is an empty tree. Nodes inserted one after the
+ * other sit next to each other in a slab, and bst_destroy frees the whole tree
+ * one slab at a time instead of one node at a time
+*/
+typedef struct BST {
+    BSTNode *root;
+    NodeSlab *slabs;
+    size_t slab_used;
+    BSTNode *free_nodes;
+} BST;
+
 /**
  * INITIALIZE_NODE - initializes the node of a bst
+ * @tree: the tree the node is for, it comes from the tree's slabs
  * @new_node_value: value of the new node being created
  * Return: the initialized node or null on failure
 */
-static BSTNode *INITIALIZE_NODE(int new_node_value)
+static BSTNode *INITIALIZE_NODE(BST *tree, int new_node_value)
 {
-    BSTNode *new_node = malloc(sizeof(BSTNode));
-    if (new_node == NULL) return NULL;
+    BSTNode *new_node = tree->free_nodes;
+    if (new_node != NULL)
+        tree->free_nodes = new_node->left;
+    else
+    {
+        if (tree->slabs == NULL || tree->slab_used == SLAB_NODES)
+        {
+            NodeSlab *slab = malloc(SLAB_SIZE);
+            if (slab == NULL) return NULL;
+            slab->next = tree->slabs;
+            tree->slabs = slab;
+            tree->slab_used = 0;
+        }
+        new_node = &tree->slabs->nodes[tree->slab_used++];
+    }
     new_node->data = new_node_value;
+    new_node->height = 1;
+    new_node->size = 1;
     new_node->left = NULL;
     new_node->right = NULL;
+    return (new_node);
+}
+
+/**
+ * free_node - gives a node back to its tree's free list
+ * @tree: the tree the node came from
+ * @node: the node, already unlinked
+*/
+static void free_node(BST *tree, BSTNode *node)
+{
+    node->left = tree->free_nodes;
+    tree->free_nodes = node;
+}
+
+/**
+ * bst_destroy - frees every node of a tree
+ * @tree: the tree, it is left empty and can be used again
+*/
+static void bst_destroy(BST *tree)
+{
+    while (tree->slabs != NULL)
+    {
+        NodeSlab *next = tree->slabs->next;
+        free(tree->slabs);
+        tree->slabs = next;
+    }
+    tree->root = NULL;
+    tree->slab_used = 0;
+    tree->free_nodes = NULL;
 }
 
 /**
  * insert_node - inserts a node to the BST
- * @root: pointer to the root of the tree that the node is being inserted to
+ * @tree: the tree that the node is being inserted to
+ * @value: the value of the new node
  * Description: all items less than a node are kept to the left of it and
  * all items greater than a node are kept to the right of it
- * Return: inserted node or null on failure
+ * Return: inserted node or null on failure (or if the value is already in the tree)
 */
-static BSTNode *insert_node(BSTNode **root, int value)
+static BSTNode *insert_node(BST *tree, int value)
 {
-    BSTNode *new_node = INITIALIZE_NODE(value);
-    if (new_node == NULL) return (NULL);
     // if there is no root, the node becomes the root
-    if(*root == NULL)
+    if (tree->root == NULL)
     {
-        *root = new_node;
-        printf("made node root\n");
-        return (new_node);
+        tree->root = INITIALIZE_NODE(tree, value);
+        if (tree->root != NULL) printf("made node root\n");
+        return (tree->root);
     }
     // go through the tree until you find where to add this node
-    BSTNode *current = *root;
+    // the node is only made once we know it goes in, so a duplicate costs nothing
+    BSTNode *new_node = NULL;
+    BSTNode *current = tree->root;
     while (current != NULL)
     {
         // if the value already exists in the bst, return NULL
         if (value == current->data) return (NULL);
         // if the value of the new node is greater than current, go right
         if (value > current->data){
-            if (current->right == NULL) 
+            if (current->right == NULL)
             {
-                current->right = new_node;
+                current->right = new_node = INITIALIZE_NODE(tree, value);
                 break;
             }
             else current = current->right;
@@ -59,16 +152,896 @@ static BSTNode *insert_node(BSTNode **root, int value)
         else if (value < current->data){
             if (current->left == NULL)
             {
-                current->left = new_node;
+                current->left = new_node = INITIALIZE_NODE(tree, value);
                 break;
             }
             else current = current->left;
         }
     }
+    if (new_node == NULL) return (NULL);
+    // every node on the way down gained one node in its subtree
+    for (current = tree->root; current != new_node; current = value < current->data ? current->left : current->right)
+        current->size++;
     return (new_node);
 }
 
 
+/**
+ * search_node - looks a value up in the tree
+ * @root: the root of the tree
+ * @value: the value to look for
+ * Return: the node holding value or NULL if it is not in the tree
+*/
+static BSTNode *search_node(BSTNode *root, int value)
+{
+    BSTNode *current = root;
+    while (current != NULL && current->data != value)
+        current = value < current->data ? current->left : current->right;
+    return (current);
+}
+
+// number of lookups bst_contains_batch keeps in flight at once
+#define BATCH_GROUP 16
+
+/**
+ * bst_contains_batch - looks many values up at once
+ * @root: the root of the tree
+ * @keys: the values to look for
+ * @n: number of values
+ * @out: gets true for every value that is in the tree
+ * Description: a lookup is a chain of loads each depending on the one before,
+ * so a loop over search_node waits out one cache miss per level. Here
+ * BATCH_GROUP lookups are interleaved: each one takes a step down, prefetches
+ * the node it lands on and hands over to the next one, and by the time it
+ * gets its turn again that node is (mostly) in cache. The misses of the whole
+ * group overlap. A lookup that ends makes room for the next key right away,
+ * so short and long paths do not hold each other up.
+*/
+static void bst_contains_batch(BSTNode *root, const int keys[], size_t n, bool out[])
+{
+    BSTNode *current[BATCH_GROUP];
+    size_t index[BATCH_GROUP];
+    const size_t slots = n < BATCH_GROUP ? n : BATCH_GROUP;
+    size_t next = 0, active = slots;
+    for (size_t j = 0; j < slots; j++)
+    {
+        index[j] = next++;
+        current[j] = root;
+    }
+    while (active > 0)
+    {
+        for (size_t j = 0; j < slots; j++)
+        {
+            if (index[j] == n)
+                continue;
+            BSTNode *node = current[j];
+            const int value = keys[index[j]];
+            if (node != NULL && node->data != value)
+            {
+                node = value < node->data ? node->left : node->right;
+                __builtin_prefetch(node);
+                current[j] = node;
+                continue;
+            }
+            out[index[j]] = node != NULL;
+            // this lookup is done, start the next key in its slot
+            if (next < n)
+            {
+                index[j] = next++;
+                current[j] = root;
+            }
+            else
+            {
+                index[j] = n;
+                active--;
+            }
+        }
+    }
+}
+
+/**
+ * delete_node - removes a value from the tree, without rebalancing
+ * @tree: the tree
+ * @value: the value to remove
+ * Return: true if the value was removed, false if it was not in the tree
+ * Description: a node with two children takes the value of its in-order
+ * successor (the smallest value of its right subtree) and the successor,
+ * which has no left child, is the node that gets unlinked
+*/
+static bool delete_node(BST *tree, int value)
+{
+    BSTNode **link = &tree->root;
+    while (*link != NULL && (*link)->data != value)
+        link = value < (*link)->data ? &(*link)->left : &(*link)->right;
+    if (*link == NULL)
+        return (false);
+    // every node from the root down to the one unlinked loses one node from its subtree
+    for (BSTNode *current = tree->root; current != *link;
+         current = value < current->data ? current->left : current->right)
+        current->size--;
+    BSTNode *node = *link;
+    if (node->left != NULL && node->right != NULL)
+    {
+        node->size--;
+        link = &node->right;
+        while ((*link)->left != NULL)
+        {
+            (*link)->size--;
+            link = &(*link)->left;
+        }
+        node->data = (*link)->data;
+        node = *link;
+    }
+    *link = node->left != NULL ? node->left : node->right;
+    free_node(tree, node);
+    return (true);
+}
+
+/**
+ * node_height - height of a subtree
+ * @node: root of the subtree, may be NULL
+ * Return: 0 for an empty subtree, otherwise the number of nodes on its longest path
+*/
+static int node_height(BSTNode *node)
+{
+    return (node == NULL ? 0 : node->height);
+}
+
+/**
+ * node_size - number of nodes in a subtree
+ * @node: root of the subtree, may be NULL
+ * Return: 0 for an empty subtree, otherwise its number of nodes
+*/
+static size_t node_size(BSTNode *node)
+{
+    return (node == NULL ? 0 : node->size);
+}
+
+/**
+ * update_height - recomputes the height and the size of a node from its children
+ * @node: the node
+*/
+static void update_height(BSTNode *node)
+{
+    const int left = node_height(node->left);
+    const int right = node_height(node->right);
+    node->height = 1 + (left > right ? left : right);
+    node->size = 1 + node_size(node->left) + node_size(node->right);
+}
+
+/**
+ * rotate_right - rotates a subtree to the right
+ * @node: root of the subtree, must have a left child
+ * Return: the new root of the subtree (the old left child)
+*/
+static BSTNode *rotate_right(BSTNode *node)
+{
+    BSTNode *pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+    update_height(node);
+    update_height(pivot);
+    return (pivot);
+}
+
+/**
+ * rotate_left - rotates a subtree to the left
+ * @node: root of the subtree, must have a right child
+ * Return: the new root of the subtree (the old right child)
+*/
+static BSTNode *rotate_left(BSTNode *node)
+{
+    BSTNode *pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    update_height(node);
+    update_height(pivot);
+    return (pivot);
+}
+
+/**
+ * rebalance - restores the AVL property at a node whose subtrees were just changed
+ * @node: root of the subtree, both of its subtrees are AVL trees whose heights
+ * differ by at most 2
+ * Return: the new root of the subtree
+ * Description: the heights of the two subtrees of every node of an AVL tree differ
+ * by at most one, which keeps the height of the tree under 1.44 log2(n).
+ * When one side is 2 higher, one rotation (or two, when the taller grandchild is
+ * on the inside) brings it back
+*/
+static BSTNode *rebalance(BSTNode *node)
+{
+    update_height(node);
+    const int balance = node_height(node->left) - node_height(node->right);
+    if (balance > 1)
+    {
+        if (node_height(node->left->left) < node_height(node->left->right))
+            node->left = rotate_left(node->left);
+        return (rotate_right(node));
+    }
+    if (balance < -1)
+    {
+        if (node_height(node->right->right) < node_height(node->right->left))
+            node->right = rotate_right(node->right);
+        return (rotate_left(node));
+    }
+    return (node);
+}
+
+/**
+ * avl_insert - recursive part of avl_insert_node
+ * @tree: the tree, new nodes come from it
+ * @node: root of the subtree the value goes into
+ * @value: the value to insert
+ * @inserted: gets the new node, stays NULL if the value is already in the tree
+ * Return: the new root of the subtree
+*/
+static BSTNode *avl_insert(BST *tree, BSTNode *node, int value, BSTNode **inserted)
+{
+    if (node == NULL)
+    {
+        *inserted = INITIALIZE_NODE(tree, value);
+        return (*inserted);
+    }
+    if (value == node->data)
+        return (node);
+    if (value < node->data)
+        node->left = avl_insert(tree, node->left, value, inserted);
+    else
+        node->right = avl_insert(tree, node->right, value, inserted);
+    return (*inserted != NULL ? rebalance(node) : node);
+}
+
+/**
+ * avl_insert_node - inserts a node to the BST, keeping it balanced
+ * @tree: the tree that the node is being inserted to
+ * @value: the value of the new node
+ * Description: the node goes where insert_node would put it, then every node on
+ * the way back up to the root is rebalanced. Sorted input gives a tree of
+ * height log2(n) instead of a linked list.
+ * Return: inserted node or null on failure (or if the value is already in the tree)
+*/
+static BSTNode *avl_insert_node(BST *tree, int value)
+{
+    BSTNode *inserted = NULL;
+    tree->root = avl_insert(tree, tree->root, value, &inserted);
+    return (inserted);
+}
+
+/**
+ * avl_delete - recursive part of avl_delete_node
+ * @tree: the tree, the deleted node goes back to it
+ * @node: root of the subtree the value is removed from
+ * @value: the value to remove
+ * @deleted: set to true when the value is found
+ * Return: the new root of the subtree
+*/
+static BSTNode *avl_delete(BST *tree, BSTNode *node, int value, bool *deleted)
+{
+    if (node == NULL)
+        return (NULL);
+    if (value < node->data)
+        node->left = avl_delete(tree, node->left, value, deleted);
+    else if (value > node->data)
+        node->right = avl_delete(tree, node->right, value, deleted);
+    else
+    {
+        *deleted = true;
+        if (node->left == NULL || node->right == NULL)
+        {
+            BSTNode *child = node->left != NULL ? node->left : node->right;
+            free_node(tree, node);
+            return (child);
+        }
+        // two children: take over the successor's value and delete the successor instead
+        BSTNode *successor = node->right;
+        while (successor->left != NULL)
+            successor = successor->left;
+        node->data = successor->data;
+        node->right = avl_delete(tree, node->right, successor->data, deleted);
+    }
+    return (*deleted ? rebalance(node) : node);
+}
+
+/**
+ * avl_delete_node - removes a value from the tree, keeping it balanced
+ * @tree: the tree
+ * @value: the value to remove
+ * Return: true if the value was removed, false if it was not in the tree
+*/
+static bool avl_delete_node(BST *tree, int value)
+{
+    bool deleted = false;
+    tree->root = avl_delete(tree, tree->root, value, &deleted);
+    return (deleted);
+}
+
+/**
+ * BSTOrder - the order a BSTIter visits the nodes in
+*/
+typedef enum BSTOrder {
+    BST_PREORDER,
+    BST_INORDER,
+    BST_POSTORDER
+} BSTOrder;
+
+/**
+ * BSTIter - a paused traversal of a tree
+ * @order: the order the nodes are visited in
+ * @stack: the nodes whose traversal is not finished, from the root down
+ * @depth: number of nodes on the stack
+ * @capacity: room on the stack, it only grows when the tree is deeper than
+ * anything seen so far, never per step
+ * @current: the next subtree to walk down into, NULL if the top of the stack
+ * comes next
+ * @last: the last node given out, the postorder walk uses it to tell if it
+ * comes back up from the right child
+ * @failed: set if the stack could not grow, the traversal then stops early
+*/
+typedef struct BSTIter {
+    BSTOrder order;
+    BSTNode **stack;
+    size_t depth;
+    size_t capacity;
+    BSTNode *current;
+    BSTNode *last;
+    bool failed;
+} BSTIter;
+
+/**
+ * iter_push - pushes a node on the stack of an iterator
+ * @iter: the iterator
+ * @node: the node
+ * Return: false if the stack could not grow
+*/
+static bool iter_push(BSTIter *iter, BSTNode *node)
+{
+    if (iter->depth == iter->capacity)
+    {
+        BSTNode **bigger = realloc(iter->stack, 2 * iter->capacity * sizeof(BSTNode *));
+        if (bigger == NULL)
+        {
+            iter->failed = true;
+            return (false);
+        }
+        iter->stack = bigger;
+        iter->capacity *= 2;
+    }
+    iter->stack[iter->depth++] = node;
+    return (true);
+}
+
+/**
+ * bst_iter_init - starts a traversal of a tree
+ * @iter: the iterator to set up
+ * @root: root of the tree, it must not change while the iterator is in use
+ * @order: BST_PREORDER, BST_INORDER or BST_POSTORDER
+ * Return: false on allocation failure
+*/
+static bool bst_iter_init(BSTIter *iter, BSTNode *root, BSTOrder order)
+{
+    iter->order = order;
+    iter->depth = 0;
+    iter->capacity = 64;
+    iter->last = NULL;
+    iter->failed = false;
+    iter->stack = malloc(iter->capacity * sizeof(BSTNode *));
+    if (iter->stack == NULL)
+        return (false);
+    // preorder keeps the nodes still to visit on the stack, the others the path down
+    iter->current = order == BST_PREORDER ? NULL : root;
+    if (order == BST_PREORDER && root != NULL)
+        iter->stack[iter->depth++] = root;
+    return (true);
+}
+
+/**
+ * bst_iter_next - moves a traversal one node forward
+ * @iter: the iterator
+ * @value: gets the value of the next node
+ * Return: false once every node has been visited
+ * Description: the iterator can be left and picked up again at any point,
+ * each call costs O(1) amortized and the stack holds at most one path
+*/
+static bool bst_iter_next(BSTIter *iter, int *value)
+{
+    BSTNode *node = NULL;
+    if (iter->failed)
+        return (false);
+    switch (iter->order)
+    {
+    case BST_PREORDER:
+        if (iter->depth == 0)
+            return (false);
+        node = iter->stack[--iter->depth];
+        // the right subtree goes under the left one so it comes out after it
+        if (node->right != NULL && !iter_push(iter, node->right))
+            return (false);
+        if (node->left != NULL && !iter_push(iter, node->left))
+            return (false);
+        break;
+    case BST_INORDER:
+        for (; iter->current != NULL; iter->current = iter->current->left)
+            if (!iter_push(iter, iter->current))
+                return (false);
+        if (iter->depth == 0)
+            return (false);
+        node = iter->stack[--iter->depth];
+        iter->current = node->right;
+        break;
+    case BST_POSTORDER:
+        for (;;)
+        {
+            for (; iter->current != NULL; iter->current = iter->current->left)
+                if (!iter_push(iter, iter->current))
+                    return (false);
+            if (iter->depth == 0)
+                return (false);
+            node = iter->stack[iter->depth - 1];
+            // go down the right subtree unless we are just coming back from it
+            if (node->right == NULL || node->right == iter->last)
+                break;
+            iter->current = node->right;
+        }
+        iter->depth--;
+        break;
+    }
+    iter->last = node;
+    *value = node->data;
+    return (true);
+}
+
+/**
+ * bst_iter_next_chunk - moves a traversal up to max nodes forward
+ * @iter: the iterator
+ * @values: gets the values of the nodes
+ * @max: room in values
+ * Return: the number of values written, less than max only at the end
+*/
+static size_t bst_iter_next_chunk(BSTIter *iter, int *values, size_t max)
+{
+    size_t n = 0;
+    while (n < max && bst_iter_next(iter, &values[n]))
+        n++;
+    return (n);
+}
+
+/**
+ * bst_iter_destroy - frees the stack of an iterator
+ * @iter: the iterator
+*/
+static void bst_iter_destroy(BSTIter *iter)
+{
+    free(iter->stack);
+    iter->stack = NULL;
+}
+
+/**
+ * bst_visit_chunks - traverses a tree, handing out the values in arrays
+ * @root: root of the tree
+ * @order: BST_PREORDER, BST_INORDER or BST_POSTORDER
+ * @chunk: number of values per call of visit
+ * @visit: gets an array of up to chunk values, in order, and their number
+ * Return: false on allocation failure
+ * Description: one indirect call per chunk instead of one per node, and the
+ * callee gets a plain array it can vectorize over
+*/
+static bool bst_visit_chunks(BSTNode *root, BSTOrder order, size_t chunk,
+                             void (*visit)(const int *, size_t))
+{
+    BSTIter iter;
+    int *values = malloc(chunk * sizeof(int));
+    if (values == NULL || !bst_iter_init(&iter, root, order))
+    {
+        free(values);
+        return (false);
+    }
+    size_t n;
+    while ((n = bst_iter_next_chunk(&iter, values, chunk)) > 0)
+        visit(values, n);
+    const bool failed = iter.failed;
+    bst_iter_destroy(&iter);
+    free(values);
+    return (!failed);
+}
+
+/**
+ * count_below - number of values of a tree less than (or equal to) a value
+ * @root: root of the tree
+ * @value: the value
+ * @inclusive: also count value itself if it is in the tree
+ * Return: the number of values
+ * Description: every time the descent goes right, the node and its whole left
+ * subtree are below value, and the subtree sizes say how many that is
+*/
+static size_t count_below(BSTNode *root, int value, bool inclusive)
+{
+    size_t count = 0;
+    while (root != NULL)
+    {
+        if (root->data < value || (inclusive && root->data == value))
+        {
+            count += node_size(root->left) + 1;
+            root = root->right;
+        }
+        else
+            root = root->left;
+    }
+    return (count);
+}
+
+/**
+ * bst_rank - number of values of a tree less than a value
+ * @root: root of the tree
+ * @value: the value, it does not have to be in the tree
+ * Return: the rank, which is the index value has or would have in sorted order
+*/
+static size_t bst_rank(BSTNode *root, int value)
+{
+    return (count_below(root, value, false));
+}
+
+/**
+ * bst_select - finds the k-th smallest value of a tree
+ * @root: root of the tree
+ * @k: the index of the value in sorted order, starting from 0
+ * @value: gets the value
+ * Return: false if the tree has k values or less
+*/
+static bool bst_select(BSTNode *root, size_t k, int *value)
+{
+    while (root != NULL)
+    {
+        const size_t left = node_size(root->left);
+        if (k == left)
+        {
+            *value = root->data;
+            return (true);
+        }
+        if (k < left)
+            root = root->left;
+        else
+        {
+            k -= left + 1;
+            root = root->right;
+        }
+    }
+    return (false);
+}
+
+/**
+ * bst_count_range - number of values of a tree in [lo, hi]
+ * @root: root of the tree
+ * @lo: smallest value counted
+ * @hi: largest value counted
+ * Return: the number of values, 0 if lo > hi
+*/
+static size_t bst_count_range(BSTNode *root, int lo, int hi)
+{
+    if (lo > hi)
+        return (0);
+    return (count_below(root, hi, true) - count_below(root, lo, false));
+}
+
+/**
+ * bst_range_scan - calls a function on every value of a tree in [lo, hi]
+ * @root: root of the tree
+ * @lo: smallest value visited
+ * @hi: largest value visited
+ * @visitor: gets the values, in increasing order
+ * Return: false on allocation failure
+ * Description: the inorder iterator is started at lo by pushing the nodes
+ * where the descent to lo goes left, so subtrees entirely below lo are never
+ * walked and the scan stops at the first value above hi
+*/
+static bool bst_range_scan(BSTNode *root, int lo, int hi, void (*visitor)(int))
+{
+    BSTIter iter;
+    if (!bst_iter_init(&iter, NULL, BST_INORDER))
+        return (false);
+    while (root != NULL)
+    {
+        if (root->data < lo)
+            root = root->right;
+        else
+        {
+            if (!iter_push(&iter, root))
+                break;
+            root = root->left;
+        }
+    }
+    int value;
+    while (bst_iter_next(&iter, &value) && value <= hi)
+        visitor(value);
+    const bool failed = iter.failed;
+    bst_iter_destroy(&iter);
+    return (!failed);
+}
+
+/**
+ * build_balanced - recursive part of bst_build_sorted
+ * @tree: the tree the nodes come from
+ * @keys: sorted values of the subtree
+ * @n: number of values
+ * Return: root of the subtree, NULL if it is empty or on allocation failure
+ * Description: the middle value becomes the root and each half becomes one of
+ * its subtrees, so the heights of the two sides differ by at most one
+*/
+static BSTNode *build_balanced(BST *tree, const int *keys, size_t n)
+{
+    if (n == 0)
+        return (NULL);
+    BSTNode *node = INITIALIZE_NODE(tree, keys[n / 2]);
+    if (node == NULL)
+        return (NULL);
+    node->left = build_balanced(tree, keys, n / 2);
+    node->right = build_balanced(tree, keys + n / 2 + 1, n - n / 2 - 1);
+    update_height(node);
+    return (node);
+}
+
+/**
+ * bst_build_sorted - builds a balanced tree out of sorted values
+ * @tree: an empty tree
+ * @keys: the values, in increasing order and without duplicates
+ * @n: number of values
+ * Return: false on allocation failure, the tree is then left empty
+ * Description: one node per value and no comparisons, so it is O(n) where n
+ * calls to avl_insert_node are O(n log n) and insert_node is O(n^2) on sorted
+ * input. The heights are set, the result is a valid AVL tree.
+*/
+static bool bst_build_sorted(BST *tree, const int *keys, size_t n)
+{
+    tree->root = build_balanced(tree, keys, n);
+    if (node_size(tree->root) != n)
+    {
+        bst_destroy(tree);
+        return (false);
+    }
+    return (true);
+}
+
+/**
+ * FrozenBST - a read only copy of a tree, laid out in breadth first order
+ * @keys: the values, keys[1] is the root and the children of keys[k] are
+ * keys[2k] and keys[2k + 1], keys[0] is unused
+ * @count: number of values
+ * Description: the Eytzinger layout has no pointers, so it takes 4 bytes per
+ * value instead of 32, and the top levels of the tree share a few cache lines.
+ * The 16 descendants of a node four levels down are contiguous, which is what
+ * frozen_bst_contains prefetches.
+*/
+typedef struct FrozenBST {
+    int *keys;
+    size_t count;
+} FrozenBST;
+
+/**
+ * inorder_values - collects the values of a tree in increasing order
+ * @root: root of the tree
+ * @count: gets the number of values
+ * Return: a malloc'ed array of the values, NULL on allocation failure or if
+ * the tree is empty
+*/
+static int *inorder_values(BSTNode *root, size_t *count)
+{
+    size_t capacity = 1024, n = 0;
+    int *values = malloc(capacity * sizeof(int));
+    BSTIter iter;
+    *count = 0;
+    if (values == NULL || !bst_iter_init(&iter, root, BST_INORDER))
+    {
+        free(values);
+        return (NULL);
+    }
+    size_t got;
+    while ((got = bst_iter_next_chunk(&iter, values + n, capacity - n)) > 0)
+    {
+        n += got;
+        if (n < capacity)
+            continue;
+        int *bigger = realloc(values, 2 * capacity * sizeof(int));
+        if (bigger == NULL)
+        {
+            iter.failed = true;
+            break;
+        }
+        values = bigger;
+        capacity *= 2;
+    }
+    const bool failed = iter.failed;
+    bst_iter_destroy(&iter);
+    if (failed || n == 0)
+    {
+        free(values);
+        return (NULL);
+    }
+    *count = n;
+    return (values);
+}
+
+/**
+ * bst_freeze - makes a read only Eytzinger copy of a tree
+ * @root: root of the tree, it is left untouched and may be any shape
+ * Return: the frozen tree or NULL on allocation failure
+ * Description: the values are read in order, then written to the slots of
+ * the implicit complete tree in its own in-order sequence, which makes it a
+ * search tree again, of height log2(n) whatever the shape of the source
+*/
+static FrozenBST *bst_freeze(BSTNode *root)
+{
+    FrozenBST *tree = calloc(1, sizeof(FrozenBST));
+    if (tree == NULL)
+        return (NULL);
+    int *values = NULL;
+    if (root != NULL && (values = inorder_values(root, &tree->count)) == NULL)
+    {
+        free(tree);
+        return (NULL);
+    }
+    // a cache line aligned array, so keys[16k..16k+15] is exactly one line
+    const size_t bytes = ((tree->count + 1) * sizeof(int) + 63) / 64 * 64;
+    tree->keys = aligned_alloc(64, bytes);
+    if (tree->keys == NULL)
+    {
+        free(values);
+        free(tree);
+        return (NULL);
+    }
+    const size_t n = tree->count;
+    // k walks the slots in order: leftmost first, then the successor of each
+    size_t k = 1;
+    while (2 * k <= n)
+        k *= 2;
+    for (size_t i = 0; i < n; i++)
+    {
+        tree->keys[k] = values[i];
+        if (2 * k + 1 <= n)
+        {
+            k = 2 * k + 1;
+            while (2 * k <= n)
+                k *= 2;
+        }
+        else
+        {
+            while (k & 1)
+                k >>= 1;
+            k >>= 1;
+        }
+    }
+    free(values);
+    return (tree);
+}
+
+/**
+ * frozen_bst_contains - looks a value up in a frozen tree
+ * @tree: the frozen tree
+ * @value: the value to look for
+ * Return: true if the value is in the tree
+ * Description: the descent has no data dependent branch, each step goes to
+ * 2k or 2k + 1 depending on a comparison result. The path taken is written in
+ * the bits of k: going right appends a 1, so once past the leaves dropping the
+ * trailing 1s and one 0 gives the last node where the descent went left, the
+ * smallest value not less than the one looked for.
+*/
+static bool frozen_bst_contains(const FrozenBST *tree, int value)
+{
+    const int *keys = tree->keys;
+    size_t k = 1;
+    while (k <= tree->count)
+    {
+        // the node 4 levels below is one of keys[16k..16k+15], one cache line
+        __builtin_prefetch((const char *)keys + 16 * k * sizeof(int));
+        k = 2 * k + (keys[k] < value);
+    }
+    k >>= __builtin_ffsll((long long)~k);
+    return (k != 0 && keys[k] == value);
+}
+
+/**
+ * delete_frozen_bst - frees a frozen tree
+ * @tree: the frozen tree
+*/
+static void delete_frozen_bst(FrozenBST *tree)
+{
+    if (tree == NULL)
+        return;
+    free(tree->keys);
+    free(tree);
+}
+
+/**
+ * NodeQueue - a growable ring buffer of nodes, first in first out
+ * @items: the buffer, its size is always a power of two
+ * @head: index of the oldest node
+ * @count: number of nodes in the queue
+ * @capacity: size of the buffer
+ * Description: a queue emptied by a traversal keeps its buffer, so passing the
+ * same one to breadth_first_traversal_with allocates nothing after the first scan
+*/
+typedef struct NodeQueue {
+    BSTNode **items;
+    size_t head;
+    size_t count;
+    size_t capacity;
+} NodeQueue;
+
+/**
+ * queue_push - appends a node to a queue, doubling the buffer when it is full
+ * @queue: the queue
+ * @node: the node
+ * Return: false on allocation failure
+*/
+static bool queue_push(NodeQueue *queue, BSTNode *node)
+{
+    if (queue->count == queue->capacity)
+    {
+        const size_t capacity = queue->capacity ? 2 * queue->capacity : 64;
+        BSTNode **items = malloc(capacity * sizeof(BSTNode *));
+        if (items == NULL)
+            return (false);
+        // unroll the ring so the oldest node is at 0 again
+        for (size_t i = 0; i < queue->count; i++)
+            items[i] = queue->items[(queue->head + i) & (queue->capacity - 1)];
+        free(queue->items);
+        queue->items = items;
+        queue->head = 0;
+        queue->capacity = capacity;
+    }
+    queue->items[(queue->head + queue->count) & (queue->capacity - 1)] = node;
+    queue->count++;
+    return (true);
+}
+
+/**
+ * queue_pop - takes the oldest node out of a queue
+ * @queue: the queue, must not be empty
+ * Return: the node
+*/
+static BSTNode *queue_pop(NodeQueue *queue)
+{
+    BSTNode *node = queue->items[queue->head];
+    queue->head = (queue->head + 1) & (queue->capacity - 1);
+    queue->count--;
+    return (node);
+}
+
+/**
+ * queue_destroy - frees the buffer of a queue
+ * @queue: the queue
+*/
+static void queue_destroy(NodeQueue *queue)
+{
+    free(queue->items);
+    queue->items = NULL;
+    queue->head = queue->count = queue->capacity = 0;
+}
+
+/**
+ * breadth_first_traversal_with - breadth_first_traversal on a caller's queue
+ * @root: root of the tree
+ * @func: function to call on each node during traversal
+ * @queue: an empty queue, zeroed or left over from an earlier traversal
+ * Return: false on allocation failure, the traversal then stops early
+ * Description: the queue holds at most one level and a half of the tree
+*/
+static bool breadth_first_traversal_with(BSTNode *root, void (*func)(int), NodeQueue *queue)
+{
+    queue->head = queue->count = 0;
+    if (root == NULL) return (true);
+    if (!queue_push(queue, root)) return (false);
+    while (queue->count > 0)
+    {
+        BSTNode *current_node = queue_pop(queue);
+        func(current_node->data);
+        if (current_node->left && !queue_push(queue, current_node->left))
+            return (false);
+        if (current_node->right && !queue_push(queue, current_node->right))
+            return (false);
+    }
+    return (true);
+}
+
 /**
  * breadth_first_traversal - traverses the tree leve wise
  * @root: pointer to the root node of the tree being traversed
@@ -78,62 +1051,266 @@ static BSTNode *insert_node(BSTNode **root, int value)
 */
 void breadth_first_traversal(BSTNode **root, void (*func)(int))
 {
-    if (*root == NULL) return;
-    // BSTNode *traversalQue[100];
-    BSTNode **traversalQue = calloc(100, sizeof(BSTNode));
-    int insert_index = 0;
-    int check_index = 0;
-    traversalQue[insert_index] = *root;
-    while (traversalQue[check_index] != NULL)
+    NodeQueue queue = {0};
+    breadth_first_traversal_with(*root, func, &queue);
+    queue_destroy(&queue);
+}
+
+// levels narrower than this are not worth waking the other threads for
+#define PARALLEL_MIN_LEVEL 4096
+
+struct LevelScan;
+
+/**
+ * LevelWorker - one thread of a parallel level order traversal
+ * @scan: the traversal it takes part in
+ * @id: its index, worker 0 is the calling thread
+ * @thread: the thread, unused for worker 0
+ * @children: the children of the nodes of its slice of the level, in order
+ * @count: number of children
+ * @capacity: room in children
+*/
+typedef struct LevelWorker {
+    struct LevelScan *scan;
+    int id;
+    pthread_t thread;
+    BSTNode **children;
+    size_t count;
+    size_t capacity;
+} LevelWorker;
+
+/**
+ * LevelScan - shared state of a parallel level order traversal
+ * @level: the nodes of the level being visited, left to right
+ * @level_size: number of nodes in it
+ * @level_capacity: room in level
+ * @next: the next level, put together from the workers' children
+ * @next_capacity: room in next
+ * @func: function to call on each node
+ * @threads: number of workers
+ * @workers: the workers
+ * @start: held while the threads are being started
+ * @barrier: every worker waits here before and after each level
+ * @done: set once there is no level left
+ * @failed: set by a worker that could not allocate
+*/
+typedef struct LevelScan {
+    BSTNode **level;
+    size_t level_size;
+    size_t level_capacity;
+    BSTNode **next;
+    size_t next_capacity;
+    void (*func)(int);
+    int threads;
+    LevelWorker *workers;
+    pthread_mutex_t start;
+    pthread_barrier_t barrier;
+    bool done;
+    bool failed;
+} LevelScan;
+
+/**
+ * visit_slice - visits a worker's share of the current level
+ * @worker: the worker
+ * Description: the level is cut into one contiguous slice per worker, so
+ * the children come out in level order once the slices are put back together
+*/
+static void visit_slice(LevelWorker *worker)
+{
+    LevelScan *scan = worker->scan;
+    size_t from = 0, to = scan->level_size;
+    if (scan->level_size >= PARALLEL_MIN_LEVEL)
     {
-        BSTNode *current_node = traversalQue[check_index];
-        func(current_node->data);
-        if (current_node->left){
-            insert_index += 1;
-            traversalQue[insert_index] = current_node->left;
-        }
-        if (current_node->right){
-            insert_index += 1;
-            traversalQue[insert_index] = current_node->right;
+        from = scan->level_size * worker->id / scan->threads;
+        to = scan->level_size * (worker->id + 1) / scan->threads;
+    }
+    else if (worker->id != 0)
+        to = 0;
+    worker->count = 0;
+    for (size_t i = from; i < to; i++)
+    {
+        BSTNode *node = scan->level[i];
+        scan->func(node->data);
+        // a node adds at most 2 children, room for them is made up front
+        if (worker->count + 2 > worker->capacity)
+        {
+            const size_t capacity = 2 * worker->capacity + 2 * (to - i);
+            BSTNode **children = realloc(worker->children, capacity * sizeof(BSTNode *));
+            if (children == NULL)
+            {
+                __atomic_store_n(&scan->failed, true, __ATOMIC_RELAXED);
+                return;
+            }
+            worker->children = children;
+            worker->capacity = capacity;
         }
-        check_index += 1;
+        if (node->left) worker->children[worker->count++] = node->left;
+        if (node->right) worker->children[worker->count++] = node->right;
+    }
+}
+
+/**
+ * level_worker - thread function of workers 1 and up
+ * @arg: the LevelWorker
+ * Return: NULL
+*/
+static void *level_worker(void *arg)
+{
+    LevelWorker *worker = arg;
+    LevelScan *scan = worker->scan;
+    pthread_mutex_lock(&scan->start);
+    pthread_mutex_unlock(&scan->start);
+    for (;;)
+    {
+        pthread_barrier_wait(&scan->barrier);
+        if (scan->done)
+            return (NULL);
+        visit_slice(worker);
+        pthread_barrier_wait(&scan->barrier);
+    }
+}
+
+/**
+ * next_level - gathers the workers' children into the next level
+ * @scan: the traversal, run by worker 0 while the others wait
+ * Return: false on allocation failure
+*/
+static bool next_level(LevelScan *scan)
+{
+    size_t size = 0;
+    for (int i = 0; i < scan->threads; i++)
+        size += scan->workers[i].count;
+    if (size > scan->next_capacity)
+    {
+        BSTNode **next = realloc(scan->next, size * sizeof(BSTNode *));
+        if (next == NULL)
+            return (false);
+        scan->next = next;
+        scan->next_capacity = size;
+    }
+    size = 0;
+    for (int i = 0; i < scan->threads; i++)
+    {
+        if (scan->workers[i].count == 0)
+            continue;
+        memcpy(scan->next + size, scan->workers[i].children,
+               scan->workers[i].count * sizeof(BSTNode *));
+        size += scan->workers[i].count;
+    }
+    // the level just visited becomes the buffer for the one after
+    BSTNode **swap = scan->level;
+    const size_t swap_capacity = scan->level_capacity;
+    scan->level = scan->next;
+    scan->level_size = size;
+    scan->level_capacity = scan->next_capacity;
+    scan->next = swap;
+    scan->next_capacity = swap_capacity;
+    return (true);
+}
+
+/**
+ * parallel_breadth_first_traversal - level order traversal on several threads
+ * @root: root of the tree
+ * @func: function to call on each node, it is called from several threads
+ * at once and must be thread safe
+ * @threads: number of threads to use, the calling thread included
+ * Return: false on allocation failure, the traversal then stops early.
+ * If fewer threads can be started than asked for, it goes on with those
+ * Description: level synchronous: every node of a level is visited before
+ * any node of the next one, but the nodes within a wide level are split
+ * between the threads and visited in no particular order.
+ * The threads stay up for the whole traversal and meet at a barrier
+ * between levels, where the calling thread stitches the next level together.
+*/
+static bool parallel_breadth_first_traversal(BSTNode *root, void (*func)(int), int threads)
+{
+    if (root == NULL) return (true);
+    if (threads < 1) threads = 1;
+    LevelScan scan = {0};
+    scan.func = func;
+    scan.workers = calloc(threads, sizeof(LevelWorker));
+    scan.level = malloc(sizeof(BSTNode *));
+    if (scan.workers == NULL || scan.level == NULL)
+    {
+        free(scan.workers);
+        free(scan.level);
+        return (false);
+    }
+    scan.level[0] = root;
+    scan.level_size = 1;
+    scan.level_capacity = 1;
+    // workers wait on start until the number of threads that could be had is known
+    pthread_mutex_init(&scan.start, NULL);
+    pthread_mutex_lock(&scan.start);
+    int started = 1;
+    for (; started < threads; started++)
+    {
+        scan.workers[started].scan = &scan;
+        scan.workers[started].id = started;
+        if (pthread_create(&scan.workers[started].thread, NULL, level_worker,
+                           &scan.workers[started]) != 0)
+            break;
+    }
+    scan.workers[0].scan = &scan;
+    scan.threads = started;
+    pthread_barrier_init(&scan.barrier, NULL, started);
+    pthread_mutex_unlock(&scan.start);
+    bool ok = true;
+    for (;;)
+    {
+        pthread_barrier_wait(&scan.barrier);
+        if (scan.done)
+            break;
+        visit_slice(&scan.workers[0]);
+        pthread_barrier_wait(&scan.barrier);
+        if (__atomic_load_n(&scan.failed, __ATOMIC_RELAXED) || !next_level(&scan))
+            ok = false;
+        scan.done = !ok || scan.level_size == 0;
     }
+    for (int i = 1; i < started; i++)
+        pthread_join(scan.workers[i].thread, NULL);
+    pthread_barrier_destroy(&scan.barrier);
+    pthread_mutex_destroy(&scan.start);
+    for (int i = 0; i < started; i++)
+        free(scan.workers[i].children);
+    free(scan.workers);
+    free(scan.level);
+    free(scan.next);
+    return (ok);
 }
 
 /**
  * preorder_traversal - performs a preorder traversal on the tree
  * @root: pointer to the root node of the tree
  * @function: function to be run on each node's value
- * Description: traverse the entire left of a node then the entire right
+ * Description: traverse the entire left of a node then the entire right.
+ * Runs on a BSTIter, so deep trees cannot overflow the call stack
 */
 void preorder_traversal(BSTNode *root, void (*function)(int))
 {
-    if (root == NULL) return;
-    function(root->data);
-    if (root->left){
-        preorder_traversal(root->left, function);
-    }
-    if (root->right){
-        preorder_traversal(root->right, function);
-    }
+    BSTIter iter;
+    int value;
+    if (!bst_iter_init(&iter, root, BST_PREORDER)) return;
+    while (bst_iter_next(&iter, &value))
+        function(value);
+    bst_iter_destroy(&iter);
 }
 
 /**
  * postorder_traversal - performs a postorder traversal on the tree
  * @root: pointer to the root node of the tree
  * @function: function to be called on each node's value
- * Description: visit all the chidlren nodes of a node before visiting the node itself
+ * Description: visit all the chidlren nodes of a node before visiting the node itself.
+ * Runs on a BSTIter, so deep trees cannot overflow the call stack
 */
 void postorder_traversal(BSTNode *root, void (*function)(int))
 {
-    if (root == NULL) return;
-    if (root->left){
-        postorder_traversal(root->left, function);
-    }
-    if (root->right){
-        postorder_traversal(root->right, function);
-    }
-    function(root->data);
+    BSTIter iter;
+    int value;
+    if (!bst_iter_init(&iter, root, BST_POSTORDER)) return;
+    while (bst_iter_next(&iter, &value))
+        function(value);
+    bst_iter_destroy(&iter);
 }
 
 /**
@@ -141,18 +1318,17 @@ void postorder_traversal(BSTNode *root, void (*function)(int))
  * @root: pointer to the root node of the tree
  * @function: functtion to be called on each node's value
  * Description: traverse the left child, then the parent then the right child
- * output should be sorted, since we are doing this on a BST
+ * output should be sorted, since we are doing this on a BST.
+ * Runs on a BSTIter, so deep trees cannot overflow the call stack
 */
 void inorder_traversal(BSTNode *root, void (*function)(int))
 {
-    if (root == NULL) return;
-    if (root->left){
-        inorder_traversal(root->left, function);
-    }
-    function(root->data);
-    if (root->right){
-        inorder_traversal(root->right, function);
-    }
+    BSTIter iter;
+    int value;
+    if (!bst_iter_init(&iter, root, BST_INORDER)) return;
+    while (bst_iter_next(&iter, &value))
+        function(value);
+    bst_iter_destroy(&iter);
 }
 
 /**
@@ -187,35 +1363,123 @@ void print_number(int n)
     printf("%d ", n);
 }
 
+static long visited_sum;
+
+void add_to_sum(int n)
+{
+    __atomic_fetch_add(&visited_sum, n, __ATOMIC_RELAXED);
+}
+
+void print_chunk(const int *values, size_t n)
+{
+    printf(" [");
+    for (size_t i = 0; i < n; i++)
+        printf(i ? " %d" : "%d", values[i]);
+    printf("]");
+}
+
 int main()
 {
     printf("BST in C\n");
-    BSTNode *root = NULL;
-    insert_node(&root, 20);
-    insert_node(&root, 11);
-    insert_node(&root, 28);
-    insert_node(&root, 30);
-    insert_node(&root, 26);
-    insert_node(&root, 9);
-    insert_node(&root, 15);
-    insert_node(&root, 20);
-    insert_node(&root, 8);
-    insert_node(&root, 10);
-    insert_node(&root, 14);
-    insert_node(&root, 16);
-    insert_node(&root, 24);
-    insert_node(&root, 29);
+    BST tree = {0};
+    insert_node(&tree, 20);
+    insert_node(&tree, 11);
+    insert_node(&tree, 28);
+    insert_node(&tree, 30);
+    insert_node(&tree, 26);
+    insert_node(&tree, 9);
+    insert_node(&tree, 15);
+    insert_node(&tree, 20);
+    insert_node(&tree, 8);
+    insert_node(&tree, 10);
+    insert_node(&tree, 14);
+    insert_node(&tree, 16);
+    insert_node(&tree, 24);
+    insert_node(&tree, 29);
 
     printf("Breadth first traversal: ");
-    breadth_first_traversal(&root, &print_number);
+    breadth_first_traversal(&tree.root, &print_number);
 
     printf("\nPreorder traversal: ");
-    preorder_traversal(root, &print_number);
+    preorder_traversal(tree.root, &print_number);
 
     printf("\nPostorder traversal: ");
-    postorder_traversal(root, &print_number);
+    postorder_traversal(tree.root, &print_number);
 
     printf("\nInorder traversal: ");
-    inorder_traversal(root, &print_number);
-    printTree(root, 5);
+    inorder_traversal(tree.root, &print_number);
+    printTree(tree.root, 5);
+
+    delete_node(&tree, 20);
+    delete_node(&tree, 9);
+    printf("\nInorder traversal after deleting 20 and 9: ");
+    inorder_traversal(tree.root, &print_number);
+    printf("\n26 is %sin the tree, 9 is %sin the tree", search_node(tree.root, 26) ? "" : "not ",
+           search_node(tree.root, 9) ? "" : "not ");
+
+    // sorted input, the balanced tree stays log2(n) high
+    BST balanced = {0};
+    for (int i = 1; i <= 15; i++)
+        avl_insert_node(&balanced, i);
+    avl_delete_node(&balanced, 8);
+    printf("\nAVL tree of 1..15 without 8, height %d: ", node_height(balanced.root));
+    inorder_traversal(balanced.root, &print_number);
+    printTree(balanced.root, 5);
+
+    // the same values, built in one pass
+    int sorted[15];
+    for (int i = 0; i < 15; i++)
+        sorted[i] = i + 1;
+    BST built = {0};
+    bst_build_sorted(&built, sorted, 15);
+    printf("\nTree built from 1..15, height %d: ", node_height(built.root));
+    preorder_traversal(built.root, &print_number);
+
+    // a pointer free copy of the first tree
+    FrozenBST *frozen = bst_freeze(tree.root);
+    printf("\nFrozen tree in breadth first order: ");
+    for (size_t k = 1; k <= frozen->count; k++)
+        print_number(frozen->keys[k]);
+    printf("\n26 is %sin the frozen tree, 9 is %sin the frozen tree\n",
+           frozen_bst_contains(frozen, 26) ? "" : "not ",
+           frozen_bst_contains(frozen, 9) ? "" : "not ");
+    delete_frozen_bst(frozen);
+
+    int median = 0;
+    bst_select(tree.root, node_size(tree.root) / 2, &median);
+    printf("First tree: median %d, rank of 25 is %zu, %zu values in [10, 26]: ", median,
+           bst_rank(tree.root, 25), bst_count_range(tree.root, 10, 26));
+    bst_range_scan(tree.root, 10, 26, &print_number);
+    printf("\n");
+    printf("Postorder traversal in chunks of 4:");
+    bst_visit_chunks(built.root, BST_POSTORDER, 4, &print_chunk);
+    printf("\n");
+
+    // a level order scan of a million nodes, on 4 threads
+    int *many = malloc(1000000 * sizeof(int));
+    for (int i = 0; i < 1000000; i++)
+        many[i] = i;
+    BST big = {0};
+    bst_build_sorted(&big, many, 1000000);
+    parallel_breadth_first_traversal(big.root, &add_to_sum, 4);
+    printf("Sum of a million nodes, visited level by level on 4 threads: %ld\n", visited_sum);
+    int p99 = 0;
+    bst_select(big.root, node_size(big.root) * 99 / 100, &p99);
+    printf("Their 99th percentile is %d\n", p99);
+    // looked up in batches, half of the even numbers up to two million are there
+    bool *found = malloc(1000000 * sizeof(bool));
+    for (int i = 0; i < 1000000; i++)
+        many[i] = 2 * i;
+    bst_contains_batch(big.root, many, 1000000, found);
+    size_t hits = 0;
+    for (int i = 0; i < 1000000; i++)
+        hits += found[i];
+    printf("%zu of the even numbers below two million found by batched lookups\n", hits);
+    free(found);
+    bst_destroy(&big);
+    free(many);
+    bst_destroy(&built);
+    bst_destroy(&balanced);
+    bst_destroy(&tree);
+    return (0);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*
+ * Benchmark of insert_node against avl_insert_node on monotonically increasing keys,
+ * and of bst_build_sorted and bst_freeze building the same tree in one pass.
+ * bst_contains_batch looks the same keys up in the AVL tree, which at 10M
+ * keys is far bigger than the last level cache.
+ * Lookups go in a scrambled order, so they miss the cache the way real ones do.
+ * Sorted input turns the unbalanced tree into a linked list, so insert_node is
+ * O(n) per key and only gets a fraction of the keys, its time for all of them
+ * is extrapolated from that (it grows with n squared).
+ * Build and run with:
+ * gcc -O2 bst_benchmark.c -o bench && ./bench [avl keys] [unbalanced keys]
+ */
+#include <time.h>
+
+// reuse the real tree code, without its demo main
+#define main bst_main
+#include "bst.c"
+#undef main
+
+/**
+ * now - reads a monotonic clock
+ * Return: the time in seconds
+*/
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * right_spine_length - number of nodes from the root following right children
+ * @root: root of the tree
+ * Return: the length of the right spine
+ * Description: sorted input makes the unbalanced tree a single right spine,
+ * so this is its height. It has no height field to read and is far too deep to recurse over
+*/
+static int right_spine_length(BSTNode *root)
+{
+    int length = 0;
+    for (; root != NULL; root = root->right)
+        length++;
+    return (length);
+}
+
+/**
+ * scrambled - the i-th key of a lookup order that jumps all over the tree
+ * @i: position in the lookup order
+ * @n: number of keys
+ * Return: a key in [0, n), every key once as long as n is not a multiple of 7919
+*/
+static int scrambled(int i, int n)
+{
+    return ((int)((long long)i * 7919 % n));
+}
+
+int main(int argc, char **argv)
+{
+    const int avl_keys = argc > 1 ? atoi(argv[1]) : 10000000;
+    const int plain_keys = argc > 2 ? atoi(argv[2]) : 30000;
+    if (avl_keys < 1 || plain_keys < 1)
+        return (1);
+
+    BST balanced = {0};
+    double start = now();
+    for (int i = 0; i < avl_keys; i++)
+        avl_insert_node(&balanced, i);
+    const double avl_insert_time = now() - start;
+    start = now();
+    long found = 0;
+    for (int i = 0; i < avl_keys; i++)
+        found += search_node(balanced.root, scrambled(i, avl_keys)) != NULL;
+    const double avl_search_time = now() - start;
+
+    int *lookups = malloc((size_t)avl_keys * sizeof(int));
+    bool *results = malloc((size_t)avl_keys * sizeof(bool));
+    for (int i = 0; i < avl_keys; i++)
+        lookups[i] = scrambled(i, avl_keys);
+    start = now();
+    bst_contains_batch(balanced.root, lookups, avl_keys, results);
+    const double batch_search_time = now() - start;
+    for (int i = 0; i < avl_keys; i++)
+        found += results[i];
+
+    int *keys = malloc((size_t)avl_keys * sizeof(int));
+    for (int i = 0; i < avl_keys; i++)
+        keys[i] = i;
+    start = now();
+    BST built = {0};
+    bst_build_sorted(&built, keys, avl_keys);
+    const double build_time = now() - start;
+    start = now();
+    for (int i = 0; i < avl_keys; i++)
+        found += search_node(built.root, scrambled(i, avl_keys)) != NULL;
+    const double build_search_time = now() - start;
+
+    start = now();
+    FrozenBST *frozen = bst_freeze(balanced.root);
+    const double freeze_time = now() - start;
+    start = now();
+    for (int i = 0; i < avl_keys; i++)
+        found += frozen_bst_contains(frozen, scrambled(i, avl_keys));
+    const double frozen_search_time = now() - start;
+
+    BST plain = {0};
+    start = now();
+    for (int i = 0; i < plain_keys; i++)
+        insert_node(&plain, i);
+    const double plain_insert_time = now() - start;
+    start = now();
+    for (int i = 0; i < plain_keys; i++)
+        found += search_node(plain.root, scrambled(i, plain_keys)) != NULL;
+    const double plain_search_time = now() - start;
+
+    const double scale = (double)avl_keys / plain_keys;
+    printf("%-16s %10s %8s %14s %14s\n", "tree", "keys", "height", "insert s", "search s");
+    printf("%-16s %10d %8d %14.3f %14.3f\n", "avl_insert_node", avl_keys, node_height(balanced.root),
+           avl_insert_time, avl_search_time);
+    printf("%-16s %10d %8d %14s %14.3f\n", "contains_batch", avl_keys, node_height(balanced.root),
+           "-", batch_search_time);
+    printf("%-16s %10d %8d %14.3f %14.3f\n", "bst_build_sorted", avl_keys, node_height(built.root),
+           build_time, build_search_time);
+    printf("%-16s %10d %8s %14.3f %14.3f\n", "bst_freeze", avl_keys, "-",
+           freeze_time, frozen_search_time);
+    printf("%-16s %10d %8d %14.3f %14.3f\n", "insert_node", plain_keys, right_spine_length(plain.root),
+           plain_insert_time, plain_search_time);
+    printf("%-16s %10d %8s %14.0f %14.0f\n", "insert_node est", avl_keys, "n",
+           plain_insert_time * scale * scale, plain_search_time * scale * scale);
+    printf("(%ld keys found)\n", found);
+    return (0);
+}
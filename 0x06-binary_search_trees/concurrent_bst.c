@@ -0,0 +1,726 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <pthread.h>
+/*
+ * Thread safe flavor of the binary search tree
+ * contains_node takes no lock at all, it walks the child pointers the way
+ * search_node does. insert_node and delete_node walk down the same way without
+ * locks, then lock only the node (or the parent and the node) they change and
+ * check that what they saw is still true, starting over if it is not.
+ * Deleting is done in two steps: the node is first marked removed, which is
+ * what makes the value disappear, and it is only unlinked from the tree when it
+ * has one child or none. A removed node with two children stays in the tree as
+ * a routing node, until one of its subtrees empties or its value is inserted again.
+ * The tree is kept balanced the AVL way, relaxed: after a change the writer goes
+ * back up the path it came down, fixing heights and rotating where one side is
+ * two taller than the other, and stops where a height does not change or where
+ * another writer changed the path under it, whose own repair takes over from there.
+ * A rotation never moves a node, it hangs copies of the rotated nodes in their
+ * place and unlinks the old ones, which keep their child pointers. A reader
+ * standing on an old node so still reaches every node that belongs under it,
+ * and a reader that ends on an unlinked node looks again.
+ * For readers to never touch freed memory, nodes are freed by epochs: every
+ * call announces the epoch it started in, unlinked nodes are retired with the
+ * epoch of the moment and only freed once the epoch has moved on twice, which it
+ * can only do after every call that might still see them has returned.
+ */
+
+// calls that can be inside the tree at the same time, more wait for a slot
+#define MAX_READERS 128
+// nodes retired between two attempts to free them
+#define RECLAIM_BATCH 256
+// nodes of the path a writer keeps to repair, an AVL tree of 2^64 nodes is less than 93 deep
+#define PATH_DEPTH 128
+
+/**
+ * BSTNode - a node of the concurrent binary search tree
+ * @data: the value held by the node, never changes
+ * @height: height of the subtree under the node, 1 for a leaf
+ * @removed: set when the value has been deleted, the node then only routes
+ * @unlinked: set once the node is no longer reachable from the root
+ * @lock: taken to change any field of the node
+ * @left: subtree of the values smaller than @data
+ * @right: subtree of the values greater than @data
+ * @next_retired: the node retired before this one
+ * @retired_epoch: the epoch it was retired in
+ * Description: @height, @removed, @unlinked, @left and @right are read without
+ * the lock, with atomic loads
+*/
+typedef struct BSTNode {
+    int data;
+    int height;
+    bool removed;
+    bool unlinked;
+    pthread_mutex_t lock;
+    struct BSTNode *left;
+    struct BSTNode *right;
+    struct BSTNode *next_retired;
+    unsigned long retired_epoch;
+} BSTNode;
+
+/*
+ * ReaderSlot - where a call announces the epoch it started in
+ * @epoch: that epoch, or 0 when no call holds the slot
+ * Description: one cache line per slot so calls never write to a shared line
+ */
+typedef struct ReaderSlot {
+    unsigned long epoch;
+} __attribute__((aligned(64))) ReaderSlot;
+
+/**
+ * ConcurrentBST - the concurrent binary search tree
+ * @holder: a node above the root, the root is its left child. It has no value,
+ * every value is on its left, so the root can be replaced like any other child
+ * @retired: the unlinked nodes not freed yet
+ * @count: number of values in the tree
+ * @retired_count: nodes retired since the last attempt to free them
+ * @reclaim_lock: held by the one thread freeing retired nodes
+ * @epoch: the current epoch, starts at 1 and only moves forward
+ * @readers: the slots of the calls inside the tree
+*/
+typedef struct ConcurrentBST {
+    BSTNode holder;
+    BSTNode *retired;
+    size_t count;
+    size_t retired_count;
+    pthread_mutex_t reclaim_lock;
+    unsigned long epoch __attribute__((aligned(64)));
+    ReaderSlot readers[MAX_READERS];
+} ConcurrentBST;
+
+/*
+ * Path - the nodes a walk went through, from the holder down
+ * @nodes: the nodes, node i is at i % PATH_DEPTH so only the deepest are kept
+ * @depth: how many nodes were walked through
+ */
+typedef struct Path {
+    BSTNode *nodes[PATH_DEPTH];
+    int depth;
+} Path;
+
+/**
+ * INITIALIZE_NODE - initializes the node of a bst
+ * @new_node_value: value of the new node being created
+ * Return: the initialized node or null on failure
+*/
+static BSTNode *INITIALIZE_NODE(int new_node_value)
+{
+    BSTNode *new_node = malloc(sizeof(BSTNode));
+    if (new_node == NULL) return NULL;
+    new_node->data = new_node_value;
+    new_node->height = 1;
+    new_node->removed = false;
+    new_node->unlinked = false;
+    pthread_mutex_init(&new_node->lock, NULL);
+    new_node->left = NULL;
+    new_node->right = NULL;
+    new_node->next_retired = NULL;
+    new_node->retired_epoch = 0;
+    return (new_node);
+}
+
+/**
+ * INITIALIZE_CBST - creates an empty concurrent tree
+ * Return: the tree or NULL on failure
+*/
+static ConcurrentBST *INITIALIZE_CBST(void)
+{
+    ConcurrentBST *tree = aligned_alloc(64, sizeof(ConcurrentBST));
+    if (tree == NULL) return (NULL);
+    memset(tree, 0, sizeof(ConcurrentBST));
+    tree->epoch = 1;
+    pthread_mutex_init(&tree->holder.lock, NULL);
+    pthread_mutex_init(&tree->reclaim_lock, NULL);
+    return (tree);
+}
+
+/**
+ * free_node - frees a node and its lock
+ * @node: the node
+*/
+static void free_node(BSTNode *node)
+{
+    pthread_mutex_destroy(&node->lock);
+    free(node);
+}
+
+/**
+ * delete_cbst - frees the tree, every node in it and every retired node
+ * @tree: the tree, no other thread may be using it
+*/
+static void delete_cbst(ConcurrentBST *tree)
+{
+    // rotate every left child up until the node has none, so no stack is needed
+    BSTNode *node = tree->holder.left;
+    while (node != NULL)
+    {
+        if (node->left != NULL)
+        {
+            BSTNode *left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+            continue;
+        }
+        BSTNode *right = node->right;
+        free_node(node);
+        node = right;
+    }
+    while (tree->retired != NULL)
+    {
+        BSTNode *next = tree->retired->next_retired;
+        free_node(tree->retired);
+        tree->retired = next;
+    }
+    pthread_mutex_destroy(&tree->holder.lock);
+    pthread_mutex_destroy(&tree->reclaim_lock);
+    free(tree);
+}
+
+/**
+ * read_lock - enters the tree, no node reachable from it is freed before the
+ * matching read_unlock
+ * @tree: the tree
+ * Return: the reader slot to hand to read_unlock
+ * Description: a thread starts looking from the slot it used last, so it
+ * normally gets the same free slot back with one compare and swap
+*/
+static int read_lock(ConcurrentBST *tree)
+{
+    static int next_hint = 0;
+    static __thread int hint = -1;
+    if (hint < 0)
+        hint = __atomic_fetch_add(&next_hint, 1, __ATOMIC_RELAXED) % MAX_READERS;
+    for (int slot = hint;; slot = (slot + 1) % MAX_READERS)
+    {
+        unsigned long free_slot = 0;
+        const unsigned long epoch = __atomic_load_n(&tree->epoch, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&tree->readers[slot].epoch, &free_slot, epoch, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            // the slot has to be visible before anything the call loads from the tree
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            hint = slot;
+            return (slot);
+        }
+        if (slot == (hint + MAX_READERS - 1) % MAX_READERS)
+            sched_yield();
+    }
+}
+
+/**
+ * read_unlock - leaves the tree
+ * @tree: the tree
+ * @reader: the slot read_lock returned
+*/
+static void read_unlock(ConcurrentBST *tree, int reader)
+{
+    __atomic_store_n(&tree->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * advance_epoch - moves the epoch on if every call inside has seen the current one
+ * @tree: the tree
+ * Return: the epoch after the attempt
+ * Description: a node retired in epoch e was unlinked before the epoch moved
+ * to e + 1, so calls that start in e + 1 cannot reach it and once the epoch
+ * is e + 2 the calls of e have all returned, it can be freed then
+*/
+static unsigned long advance_epoch(ConcurrentBST *tree)
+{
+    unsigned long epoch = __atomic_load_n(&tree->epoch, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+        const unsigned long reader = __atomic_load_n(&tree->readers[i].epoch, __ATOMIC_ACQUIRE);
+        if (reader != 0 && reader != epoch)
+            return (epoch);
+    }
+    __atomic_compare_exchange_n(&tree->epoch, &epoch, epoch + 1, 0,
+                                __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&tree->epoch, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * retire - puts an unlinked node on the retired list
+ * @tree: the tree
+ * @node: the node, already unreachable from the root
+*/
+static void retire(ConcurrentBST *tree, BSTNode *node)
+{
+    // the unlinking store has to be visible before the epoch is read
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    node->retired_epoch = __atomic_load_n(&tree->epoch, __ATOMIC_ACQUIRE);
+    BSTNode *head = __atomic_load_n(&tree->retired, __ATOMIC_RELAXED);
+    do
+        node->next_retired = head;
+    while (!__atomic_compare_exchange_n(&tree->retired, &head, node, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&tree->retired_count, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * reclaim - frees the retired nodes no call can reach anymore
+ * @tree: the tree
+ * Description: called outside read_lock, every RECLAIM_BATCH retired nodes.
+ * One thread at a time takes the whole list, frees what is old enough and puts
+ * the rest back, threads that find the list taken just go on.
+*/
+static void reclaim(ConcurrentBST *tree)
+{
+    if (__atomic_load_n(&tree->retired_count, __ATOMIC_RELAXED) < RECLAIM_BATCH ||
+        pthread_mutex_trylock(&tree->reclaim_lock) != 0)
+        return;
+    __atomic_store_n(&tree->retired_count, 0, __ATOMIC_RELAXED);
+    const unsigned long epoch = advance_epoch(tree);
+    BSTNode *node = __atomic_exchange_n(&tree->retired, NULL, __ATOMIC_ACQUIRE);
+    BSTNode *kept = NULL;
+    BSTNode *last_kept = NULL;
+    while (node != NULL)
+    {
+        BSTNode *next = node->next_retired;
+        if (node->retired_epoch + 2 <= epoch)
+            free_node(node);
+        else
+        {
+            node->next_retired = kept;
+            if (kept == NULL)
+                last_kept = node;
+            kept = node;
+        }
+        node = next;
+    }
+    if (kept != NULL)
+    {
+        BSTNode *head = __atomic_load_n(&tree->retired, __ATOMIC_RELAXED);
+        do
+            last_kept->next_retired = head;
+        while (!__atomic_compare_exchange_n(&tree->retired, &head, kept, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+    pthread_mutex_unlock(&tree->reclaim_lock);
+}
+
+/**
+ * child_link - the child pointer of a node a value is found under
+ * @tree: the tree
+ * @node: the node
+ * @value: the value
+ * Return: the address of the left or right pointer of node
+*/
+static inline BSTNode **child_link(ConcurrentBST *tree, BSTNode *node, int value)
+{
+    return (node == &tree->holder || value < node->data ? &node->left : &node->right);
+}
+
+/**
+ * height - height of a subtree, read without its lock
+ * @node: root of the subtree, may be NULL
+ * Return: the height, 0 for an empty subtree
+*/
+static inline int height(BSTNode *node)
+{
+    return (node == NULL ? 0 : __atomic_load_n(&node->height, __ATOMIC_RELAXED));
+}
+
+/**
+ * path_push - appends a node to a path
+ * @path: the path
+ * @node: the node
+*/
+static inline void path_push(Path *path, BSTNode *node)
+{
+    path->nodes[path->depth % PATH_DEPTH] = node;
+    path->depth++;
+}
+
+/**
+ * find - walks down to a value without taking any lock
+ * @tree: the tree
+ * @value: the value to look for
+ * @path: gets the nodes walked through, the node returned excluded, may be NULL
+ * Return: the node holding value, removed or not, or NULL if there is none, in
+ * which case the value belongs under the last node of the path
+*/
+static BSTNode *find(ConcurrentBST *tree, int value, Path *path)
+{
+    BSTNode *node = __atomic_load_n(&tree->holder.left, __ATOMIC_ACQUIRE);
+    if (path != NULL)
+    {
+        path->depth = 0;
+        path_push(path, &tree->holder);
+    }
+    while (node != NULL && node->data != value)
+    {
+        if (path != NULL)
+            path_push(path, node);
+        node = __atomic_load_n(child_link(tree, node, value), __ATOMIC_ACQUIRE);
+    }
+    return (node);
+}
+
+/**
+ * contains_node - looks a value up in the tree, without locking
+ * @tree: the tree
+ * @value: the value to look for
+ * Return: true if the value is in the tree
+ * Description: a node found unlinked may have been copied by a rotation and
+ * changed since, the walk is then done again
+*/
+static bool contains_node(ConcurrentBST *tree, int value)
+{
+    const int reader = read_lock(tree);
+    bool found;
+    for (;;)
+    {
+        BSTNode *node = find(tree, value, NULL);
+        if (node == NULL)
+        {
+            found = false;
+            break;
+        }
+        const bool removed = __atomic_load_n(&node->removed, __ATOMIC_ACQUIRE);
+        if (!__atomic_load_n(&node->unlinked, __ATOMIC_ACQUIRE))
+        {
+            found = !removed;
+            break;
+        }
+    }
+    read_unlock(tree, reader);
+    return (found);
+}
+
+/**
+ * copy_node - makes the copy of a node a rotation hangs in its place
+ * @node: the node, locked
+ * @left: left child of the copy
+ * @right: right child of the copy
+ * Return: the copy or NULL on failure
+*/
+static BSTNode *copy_node(BSTNode *node, BSTNode *left, BSTNode *right)
+{
+    BSTNode *copy = INITIALIZE_NODE(node->data);
+    if (copy == NULL)
+        return (NULL);
+    const int left_height = height(left);
+    const int right_height = height(right);
+    copy->height = 1 + (left_height > right_height ? left_height : right_height);
+    copy->removed = node->removed;
+    copy->left = left;
+    copy->right = right;
+    return (copy);
+}
+
+/**
+ * rotate - rotates the taller side of a node up
+ * @tree: the tree
+ * @link: the pointer to the node in its parent, the parent is locked
+ * @node: the node, locked
+ * @left_heavy: true if the left subtree is the taller one
+ * Return: true if the node was rotated, false on allocation failure, the tree
+ * is then left as it was
+ * Description: the taller child is locked and, when its inner subtree is the
+ * taller of its two, that grandchild too, for a double rotation. Copies of the
+ * two or three nodes are built with their new children, then the old ones are
+ * marked unlinked and the copy on top replaces the node in one store.
+*/
+static bool rotate(ConcurrentBST *tree, BSTNode **link, BSTNode *node, bool left_heavy)
+{
+    BSTNode *child = left_heavy ? node->left : node->right;
+    pthread_mutex_lock(&child->lock);
+    BSTNode *outer = left_heavy ? child->left : child->right;
+    BSTNode *inner = left_heavy ? child->right : child->left;
+    BSTNode *grandchild = height(inner) > height(outer) ? inner : NULL;
+    BSTNode *top = NULL;
+    BSTNode *new_node = NULL;
+    BSTNode *new_child = NULL;
+    if (grandchild == NULL)
+    {
+        if (left_heavy)
+        {
+            if ((new_node = copy_node(node, inner, node->right)) != NULL)
+                top = new_child = copy_node(child, outer, new_node);
+        }
+        else if ((new_node = copy_node(node, node->left, inner)) != NULL)
+            top = new_child = copy_node(child, new_node, outer);
+    }
+    else
+    {
+        pthread_mutex_lock(&grandchild->lock);
+        if (left_heavy)
+        {
+            new_child = copy_node(child, outer, grandchild->left);
+            new_node = copy_node(node, grandchild->right, node->right);
+            if (new_child != NULL && new_node != NULL)
+                top = copy_node(grandchild, new_child, new_node);
+        }
+        else
+        {
+            new_node = copy_node(node, node->left, grandchild->left);
+            new_child = copy_node(child, grandchild->right, outer);
+            if (new_child != NULL && new_node != NULL)
+                top = copy_node(grandchild, new_node, new_child);
+        }
+    }
+    if (top != NULL)
+    {
+        __atomic_store_n(&node->unlinked, true, __ATOMIC_RELEASE);
+        __atomic_store_n(&child->unlinked, true, __ATOMIC_RELEASE);
+        if (grandchild != NULL)
+            __atomic_store_n(&grandchild->unlinked, true, __ATOMIC_RELEASE);
+        __atomic_store_n(link, top, __ATOMIC_RELEASE);
+    }
+    if (grandchild != NULL)
+        pthread_mutex_unlock(&grandchild->lock);
+    pthread_mutex_unlock(&child->lock);
+    if (top == NULL)
+    {
+        if (new_node != NULL)
+            free_node(new_node);
+        if (new_child != NULL)
+            free_node(new_child);
+        return (false);
+    }
+    // the caller unlocks the node before retiring it
+    retire(tree, child);
+    if (grandchild != NULL)
+        retire(tree, grandchild);
+    return (true);
+}
+
+/**
+ * repair_node - fixes one node on the way back up
+ * @tree: the tree
+ * @parent: the parent the node was seen under
+ * @node: the node
+ * Return: true if the height of the subtree under parent may have changed, so
+ * the parent has to be repaired next, false to stop
+ * Description: the parent is locked before the node, as everywhere else locks
+ * are only ever taken from the top down, so two threads cannot deadlock.
+ * A removed node with one child or none is unlinked, its only child, if it has
+ * one, taking its place under the parent. The node keeps its child pointers,
+ * so a reader standing on it carries on into the subtree, which is still in
+ * the tree one level up. Otherwise the node is rotated if it is out of balance,
+ * or gets its height updated.
+*/
+static bool repair_node(ConcurrentBST *tree, BSTNode *parent, BSTNode *node)
+{
+    pthread_mutex_lock(&parent->lock);
+    BSTNode **link = child_link(tree, parent, node->data);
+    // the node is unlinked only by changing this link, so it is still in the tree
+    if (parent->unlinked || *link != node)
+    {
+        pthread_mutex_unlock(&parent->lock);
+        return (false);
+    }
+    pthread_mutex_lock(&node->lock);
+    BSTNode *left = node->left;
+    BSTNode *right = node->right;
+    bool unlinked = false;
+    bool changed = true;
+    if (node->removed && (left == NULL || right == NULL))
+    {
+        __atomic_store_n(link, left != NULL ? left : right, __ATOMIC_RELEASE);
+        __atomic_store_n(&node->unlinked, true, __ATOMIC_RELEASE);
+        unlinked = true;
+    }
+    else
+    {
+        const int left_height = height(left);
+        const int right_height = height(right);
+        const int new_height = 1 + (left_height > right_height ? left_height : right_height);
+        if (left_height - right_height > 1 || right_height - left_height > 1)
+            changed = unlinked = rotate(tree, link, node, left_height > right_height);
+        else if (new_height != node->height)
+            __atomic_store_n(&node->height, new_height, __ATOMIC_RELAXED);
+        else
+            changed = false;
+    }
+    pthread_mutex_unlock(&node->lock);
+    pthread_mutex_unlock(&parent->lock);
+    if (unlinked)
+        retire(tree, node);
+    return (changed);
+}
+
+/**
+ * repair - fixes the path a writer came down, from the bottom up
+ * @tree: the tree
+ * @path: the path, its last node is the deepest one that changed
+*/
+static void repair(ConcurrentBST *tree, Path *path)
+{
+    const int top = path->depth > PATH_DEPTH ? path->depth - PATH_DEPTH : 0;
+    for (int i = path->depth - 1; i > top; i--)
+        if (!repair_node(tree, path->nodes[(i - 1) % PATH_DEPTH], path->nodes[i % PATH_DEPTH]))
+            break;
+}
+
+/**
+ * insert_node - inserts a value to the tree
+ * @tree: the tree
+ * @value: the value to insert
+ * Return: true if the value was added, false if it was already in the tree
+ * or on allocation failure
+ * Description: a removed node still holding the value is brought back,
+ * otherwise a new node is hung under the parent the walk ended at, after
+ * checking under the parent's lock that the parent is still in the tree and
+ * that nothing was hung there in the meantime, and the path is repaired
+*/
+static bool insert_node(ConcurrentBST *tree, int value)
+{
+    const int reader = read_lock(tree);
+    BSTNode *new_node = NULL;
+    bool added;
+    Path path;
+    for (;;)
+    {
+        BSTNode *node = find(tree, value, &path);
+        if (node != NULL)
+        {
+            pthread_mutex_lock(&node->lock);
+            if (node->unlinked)
+            {
+                pthread_mutex_unlock(&node->lock);
+                continue;
+            }
+            added = node->removed;
+            __atomic_store_n(&node->removed, false, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&node->lock);
+            if (new_node != NULL)
+                free_node(new_node);
+            break;
+        }
+        // allocate before locking, so the lock is held as briefly as possible
+        if (new_node == NULL && (new_node = INITIALIZE_NODE(value)) == NULL)
+        {
+            added = false;
+            break;
+        }
+        BSTNode *parent = path.nodes[(path.depth - 1) % PATH_DEPTH];
+        pthread_mutex_lock(&parent->lock);
+        BSTNode **link = child_link(tree, parent, value);
+        if (parent->unlinked || *link != NULL)
+        {
+            pthread_mutex_unlock(&parent->lock);
+            continue;
+        }
+        __atomic_store_n(link, new_node, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&parent->lock);
+        repair(tree, &path);
+        added = true;
+        break;
+    }
+    read_unlock(tree, reader);
+    if (added)
+        __atomic_fetch_add(&tree->count, 1, __ATOMIC_RELAXED);
+    reclaim(tree);
+    return (added);
+}
+
+/**
+ * delete_node - removes a value from the tree
+ * @tree: the tree
+ * @value: the value to remove
+ * Return: true if the value was removed, false if it was not in the tree
+ * Description: marking the node removed takes the value out at once. Then the
+ * path is repaired from the node up, which unlinks the node if it can be, and
+ * any routing node above it left with one child or none.
+*/
+static bool delete_node(ConcurrentBST *tree, int value)
+{
+    const int reader = read_lock(tree);
+    Path path;
+    BSTNode *node;
+    for (;;)
+    {
+        node = find(tree, value, &path);
+        if (node == NULL)
+            break;
+        pthread_mutex_lock(&node->lock);
+        if (!node->unlinked)
+            break;
+        pthread_mutex_unlock(&node->lock);
+    }
+    bool removed = false;
+    if (node != NULL)
+    {
+        removed = !node->removed;
+        __atomic_store_n(&node->removed, true, __ATOMIC_RELEASE);
+        const bool unlinkable = node->left == NULL || node->right == NULL;
+        pthread_mutex_unlock(&node->lock);
+        if (removed && unlinkable)
+        {
+            path_push(&path, node);
+            repair(tree, &path);
+        }
+    }
+    read_unlock(tree, reader);
+    if (removed)
+        __atomic_fetch_sub(&tree->count, 1, __ATOMIC_RELAXED);
+    reclaim(tree);
+    return (removed);
+}
+
+/**
+ * count_values - number of values in the tree
+ * @tree: the tree
+ * Return: the count, which may be out of date by the time it is read
+*/
+static size_t count_values(ConcurrentBST *tree)
+{
+    return (__atomic_load_n(&tree->count, __ATOMIC_RELAXED));
+}
+
+#define DEMO_THREADS 4
+#define DEMO_KEYS 20000
+
+/**
+ * demo_writer - inserts and deletes its own slice of values
+ * @arg: the tree
+ * Return: NULL
+*/
+static void *demo_writer(void *arg)
+{
+    static int next_id = 0;
+    ConcurrentBST *tree = arg;
+    const int id = __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED);
+    // in increasing order, which the rotations keep from turning into a list
+    for (int i = id; i < DEMO_KEYS; i += DEMO_THREADS)
+        insert_node(tree, i);
+    for (int i = id; i < DEMO_KEYS; i += 2 * DEMO_THREADS)
+        delete_node(tree, i);
+    return (NULL);
+}
+
+int main()
+{
+    printf("Concurrent BST in C\n");
+    ConcurrentBST *tree = INITIALIZE_CBST();
+    if (tree == NULL)
+        return (1);
+    insert_node(tree, 20);
+    insert_node(tree, 11);
+    insert_node(tree, 28);
+    delete_node(tree, 20);
+    printf("20 is %sin the tree, 28 is %sin the tree\n", contains_node(tree, 20) ? "" : "not ",
+           contains_node(tree, 28) ? "" : "not ");
+    delete_node(tree, 11);
+    delete_node(tree, 28);
+
+    pthread_t threads[DEMO_THREADS];
+    for (int i = 0; i < DEMO_THREADS; i++)
+        pthread_create(&threads[i], NULL, demo_writer, tree);
+    for (int i = 0; i < DEMO_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    // the values deleted are the ones with i % 8 < 4
+    printf("11676 is %sin the tree, 7919 is %sin the tree\n", contains_node(tree, 11676) ? "" : "not ",
+           contains_node(tree, 7919) ? "" : "not ");
+    printf("count: %zu, height: %d\n", count_values(tree), height(tree->holder.left));
+    delete_cbst(tree);
+    return (0);
+}
@@ -0,0 +1,167 @@
+/*
+ * Scaling benchmark of the concurrent tree in concurrent_bst.c
+ * Runs a read-mostly (90% contains) and a write-heavy (50% contains) mix on 1 to
+ * MAX_THREADS threads, against the same tree with every call behind one
+ * global mutex as the baseline, which is how insert_node of bst.c has to be shared.
+ * The write-heavy mix is run a second time on sorted keys: the tree is filled in
+ * increasing order and every thread walks up its own run of values, which an
+ * unbalanced tree would turn into a list.
+ * Build and run with:
+ * gcc -O2 concurrent_bst_benchmark.c -o bench -pthread && ./bench [max threads]
+ */
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#define main concurrent_bst_main
+#include "concurrent_bst.c"
+#undef main
+
+#define NUM_KEYS 1000000
+#define OPS_PER_THREAD 500000
+
+/*
+ * BenchArgs - what every benchmark thread gets
+ * @tree: the shared tree
+ * @contains_percent: share of the operations that are lookups, the rest are
+ * inserts and deletes in equal parts
+ * @global_lock: when not NULL, every call is made holding it
+ * @rng: per thread xorshift state
+ * @next_value: with sorted keys, the value of the next operation, otherwise -1
+ * and the values are random
+ */
+typedef struct BenchArgs {
+    ConcurrentBST *tree;
+    int contains_percent;
+    pthread_mutex_t *global_lock;
+    uint64_t rng;
+    int next_value;
+} BenchArgs;
+
+/**
+ * now - reads a monotonic clock
+ * Return: the time in seconds
+*/
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * next_random - xorshift64 step
+ * @state: the generator state, never 0
+ * Return: the next random number
+*/
+static inline uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (*state);
+}
+
+/**
+ * bench_thread - runs OPS_PER_THREAD random operations on the tree
+ * @arg: the BenchArgs of this thread
+ * Return: NULL
+*/
+static void *bench_thread(void *arg)
+{
+    BenchArgs *args = arg;
+    for (int op = 0; op < OPS_PER_THREAD; op++)
+    {
+        const uint64_t r = next_random(&args->rng);
+        int value = (int)((r >> 8) % NUM_KEYS);
+        if (args->next_value >= 0)
+        {
+            value = args->next_value;
+            args->next_value = (value + 1) % NUM_KEYS;
+        }
+        const int kind = (int)(r % 100);
+        if (args->global_lock != NULL)
+            pthread_mutex_lock(args->global_lock);
+        if (kind < args->contains_percent)
+            contains_node(args->tree, value);
+        else if (kind & 1)
+            insert_node(args->tree, value);
+        else
+            delete_node(args->tree, value);
+        if (args->global_lock != NULL)
+            pthread_mutex_unlock(args->global_lock);
+    }
+    return (NULL);
+}
+
+/**
+ * run - times one mix on a given number of threads
+ * @num_threads: how many threads to run
+ * @contains_percent: share of lookups in the mix
+ * @global_lock: NULL for the fine grained tree, or the mutex to wrap every call in
+ * @sorted: true to fill the tree and pick the values in increasing order
+ * Return: operations per second over all threads
+*/
+static double run(int num_threads, int contains_percent, pthread_mutex_t *global_lock, bool sorted)
+{
+    ConcurrentBST *tree = INITIALIZE_CBST();
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    BenchArgs *args = malloc(num_threads * sizeof(BenchArgs));
+    if (tree == NULL || threads == NULL || args == NULL)
+        exit(1);
+    // start from a tree holding half of the values, inserted in a scrambled order or sorted
+    for (int i = 0; i < NUM_KEYS; i += 2)
+        insert_node(tree, sorted ? i : (int)((long long)i * 7919 % NUM_KEYS));
+    const double start = now();
+    for (int t = 0; t < num_threads; t++)
+    {
+        args[t] = (BenchArgs){tree, contains_percent, global_lock, 0x9E3779B97F4A7C15ULL * (t + 1),
+                              sorted ? (int)((long long)NUM_KEYS * t / num_threads) : -1};
+        pthread_create(&threads[t], NULL, bench_thread, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+        pthread_join(threads[t], NULL);
+    const double elapsed = now() - start;
+    delete_cbst(tree);
+    free(threads);
+    free(args);
+    return ((double)num_threads * OPS_PER_THREAD / elapsed);
+}
+
+/**
+ * print_row - times one mix on the fine grained tree and behind the global lock
+ * @num_threads: how many threads to run
+ * @contains_percent: share of lookups in the mix
+ * @global_lock: the mutex of the baseline
+ * @sorted: true for sorted keys
+*/
+static void print_row(int num_threads, int contains_percent, pthread_mutex_t *global_lock, bool sorted)
+{
+    const double fine = run(num_threads, contains_percent, NULL, sorted);
+    const double locked = run(num_threads, contains_percent, global_lock, sorted);
+    printf("%8d %16.0f %18.0f\n", num_threads, fine, locked);
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 1)
+        max_threads = atoi(argv[1]);
+    if (max_threads < 1)
+        max_threads = 1;
+    pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+    const int mixes[] = {90, 50, 50};
+    const bool sorted[] = {false, false, true};
+
+    printf("%d cpus online\n", (int)sysconf(_SC_NPROCESSORS_ONLN));
+    for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++)
+    {
+        printf("\n%d%% contains%s:\n%8s %16s %18s\n", mixes[m], sorted[m] ? ", sorted keys" : "",
+               "threads", "fine ops/s", "global lock ops/s");
+        // the powers of two below max_threads, then max_threads itself
+        for (int t = 1; t < max_threads; t *= 2)
+            print_row(t, mixes[m], &global_lock, sorted[m]);
+        print_row(max_threads, mixes[m], &global_lock, sorted[m]);
+    }
+    return (0);
+}
@@ -0,0 +1,467 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+/*
+ * Persistent flavor of the binary search tree
+ * Nodes are never changed once made. An insert or a delete copies the nodes on
+ * the path from the root down to the change (and the ones a rotation moves),
+ * and the copies point at the same untouched subtrees as the originals, so each
+ * update makes a new version of the tree for O(log n) new nodes.
+ * A snapshot is a counted reference to the root of one version: taking one is
+ * O(1) and nothing a writer does afterwards changes what it sees, so a reader
+ * can walk it for as long as it likes without any lock.
+ * Every node counts the parents and snapshots pointing at it, a node whose
+ * count drops to 0 gives up its references to its children and is freed, so an
+ * old version goes away exactly when the last snapshot of it is released.
+ * The versions are AVL balanced, as in avl_insert_node of bst.c.
+ */
+
+// deeper than any AVL tree that fits in memory (1.44 log2(n) levels)
+#define MAX_HEIGHT 128
+
+/**
+ * BSTNode - a node of the persistent binary search tree
+ * @data: the value held by the node
+ * @height: number of nodes on the longest path from this node down to a leaf
+ * @refs: number of parent nodes and snapshots pointing at this node
+ * @left: subtree of the values smaller than @data
+ * @right: subtree of the values greater than @data
+ * Description: only @refs ever changes after the node is made, atomically,
+ * since versions shared between threads share nodes
+*/
+typedef struct BSTNode {
+    int data;
+    int height;
+    unsigned int refs;
+    struct BSTNode *left;
+    struct BSTNode *right;
+} BSTNode;
+
+/**
+ * PersistentBST - the latest version of a persistent tree
+ * @write_lock: serializes the writers, held while a new version is built
+ * @root_lock: held just long enough to swap the root or take a reference to it
+ * @root: root of the latest version, the tree holds one reference to it
+ * @count: number of values in the latest version
+*/
+typedef struct PersistentBST {
+    pthread_mutex_t write_lock;
+    pthread_mutex_t root_lock;
+    BSTNode *root;
+    size_t count;
+} PersistentBST;
+
+/**
+ * node_height - height of a subtree
+ * @node: root of the subtree, may be NULL
+ * Return: 0 for an empty subtree, otherwise the number of nodes on its longest path
+*/
+static int node_height(const BSTNode *node)
+{
+    return (node == NULL ? 0 : node->height);
+}
+
+/**
+ * retain - takes one more reference to a node
+ * @node: the node, may be NULL
+ * Return: node
+*/
+static BSTNode *retain(BSTNode *node)
+{
+    if (node != NULL)
+        __atomic_fetch_add(&node->refs, 1, __ATOMIC_RELAXED);
+    return (node);
+}
+
+/**
+ * release - drops a reference to a node, freeing what is no longer referenced
+ * @node: the node, may be NULL
+ * Description: a node whose last reference goes drops its references to its
+ * children in turn. The release order makes every other thread's changes to
+ * a node happen before it is freed.
+*/
+static void release(BSTNode *node)
+{
+    BSTNode *stack[MAX_HEIGHT * 2];
+    size_t depth = 0;
+    if (node != NULL)
+        stack[depth++] = node;
+    while (depth > 0)
+    {
+        node = stack[--depth];
+        if (__atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) != 0)
+            continue;
+        // each freed node adds at most 2 and takes 1, the stack never grows past 2 * height
+        if (node->left != NULL)
+            stack[depth++] = node->left;
+        if (node->right != NULL)
+            stack[depth++] = node->right;
+        free(node);
+    }
+}
+
+/**
+ * INITIALIZE_NODE - makes a node of a persistent tree
+ * @new_node_value: value of the new node
+ * @left: its left subtree, the node takes a reference to it
+ * @right: its right subtree, the node takes a reference to it
+ * Return: the node, with one reference owned by the caller, or NULL on failure
+*/
+static BSTNode *INITIALIZE_NODE(int new_node_value, BSTNode *left, BSTNode *right)
+{
+    BSTNode *new_node = malloc(sizeof(BSTNode));
+    if (new_node == NULL) return NULL;
+    const int left_height = node_height(left);
+    const int right_height = node_height(right);
+    new_node->data = new_node_value;
+    new_node->height = 1 + (left_height > right_height ? left_height : right_height);
+    new_node->refs = 1;
+    new_node->left = retain(left);
+    new_node->right = retain(right);
+    return (new_node);
+}
+
+/**
+ * balanced_node - makes a node out of a value and two subtrees, rotating
+ * when their heights differ by 2
+ * @value: the value of the node
+ * @left: the left subtree, borrowed
+ * @right: the right subtree, borrowed
+ * @failed: set on allocation failure
+ * Return: the new root of the subtree, owned by the caller, or NULL on failure
+ * Description: the rotations of rebalance in bst.c, except that the nodes
+ * they would move are copied instead
+*/
+static BSTNode *balanced_node(int value, BSTNode *left, BSTNode *right, bool *failed)
+{
+    BSTNode *inner_left = NULL, *inner_right = NULL, *root = NULL;
+    const int balance = node_height(left) - node_height(right);
+    if (balance > 1 && node_height(left->left) >= node_height(left->right))
+    {
+        inner_right = INITIALIZE_NODE(value, left->right, right);
+        if (inner_right != NULL)
+            root = INITIALIZE_NODE(left->data, left->left, inner_right);
+    }
+    else if (balance > 1)
+    {
+        // the taller grandchild is on the inside, it becomes the root
+        BSTNode *pivot = left->right;
+        inner_left = INITIALIZE_NODE(left->data, left->left, pivot->left);
+        inner_right = INITIALIZE_NODE(value, pivot->right, right);
+        if (inner_left != NULL && inner_right != NULL)
+            root = INITIALIZE_NODE(pivot->data, inner_left, inner_right);
+    }
+    else if (balance < -1 && node_height(right->right) >= node_height(right->left))
+    {
+        inner_left = INITIALIZE_NODE(value, left, right->left);
+        if (inner_left != NULL)
+            root = INITIALIZE_NODE(right->data, inner_left, right->right);
+    }
+    else if (balance < -1)
+    {
+        BSTNode *pivot = right->left;
+        inner_left = INITIALIZE_NODE(value, left, pivot->left);
+        inner_right = INITIALIZE_NODE(right->data, pivot->right, right->right);
+        if (inner_left != NULL && inner_right != NULL)
+            root = INITIALIZE_NODE(pivot->data, inner_left, inner_right);
+    }
+    else
+        root = INITIALIZE_NODE(value, left, right);
+    // the new root holds its own references to the inner nodes
+    release(inner_left);
+    release(inner_right);
+    if (root == NULL)
+        *failed = true;
+    return (root);
+}
+
+/**
+ * persistent_insert - recursive part of pbst_insert
+ * @node: root of the subtree the value goes into, borrowed
+ * @value: the value to insert
+ * @inserted: set when a node was added
+ * @failed: set on allocation failure
+ * Return: root of the new version of the subtree, owned by the caller, or
+ * node itself with one more reference if nothing changed
+*/
+static BSTNode *persistent_insert(BSTNode *node, int value, bool *inserted, bool *failed)
+{
+    if (node == NULL)
+    {
+        BSTNode *leaf = INITIALIZE_NODE(value, NULL, NULL);
+        *inserted = leaf != NULL;
+        *failed = leaf == NULL;
+        return (leaf);
+    }
+    if (value == node->data)
+        return (retain(node));
+    const bool go_left = value < node->data;
+    BSTNode *child = persistent_insert(go_left ? node->left : node->right, value, inserted, failed);
+    BSTNode *result = NULL;
+    if (!*failed && !*inserted)
+        result = retain(node);
+    else if (!*failed)
+        result = go_left ? balanced_node(node->data, child, node->right, failed)
+                         : balanced_node(node->data, node->left, child, failed);
+    release(child);
+    return (result);
+}
+
+/**
+ * persistent_delete - recursive part of pbst_delete
+ * @node: root of the subtree the value is removed from, borrowed
+ * @value: the value to remove
+ * @deleted: set when the value was found
+ * @failed: set on allocation failure
+ * Return: root of the new version of the subtree, owned by the caller, or
+ * node itself with one more reference if nothing changed
+*/
+static BSTNode *persistent_delete(BSTNode *node, int value, bool *deleted, bool *failed)
+{
+    if (node == NULL)
+        return (NULL);
+    if (value == node->data)
+    {
+        *deleted = true;
+        if (node->left == NULL || node->right == NULL)
+            return (retain(node->left != NULL ? node->left : node->right));
+        // two children: the successor's value moves up and the successor is deleted instead
+        BSTNode *successor = node->right;
+        while (successor->left != NULL)
+            successor = successor->left;
+        BSTNode *right = persistent_delete(node->right, successor->data, deleted, failed);
+        BSTNode *result = *failed ? NULL : balanced_node(successor->data, node->left, right, failed);
+        release(right);
+        return (result);
+    }
+    const bool go_left = value < node->data;
+    BSTNode *child = persistent_delete(go_left ? node->left : node->right, value, deleted, failed);
+    BSTNode *result = NULL;
+    if (!*failed && !*deleted)
+        result = retain(node);
+    else if (!*failed)
+        result = go_left ? balanced_node(node->data, child, node->right, failed)
+                         : balanced_node(node->data, node->left, child, failed);
+    release(child);
+    return (result);
+}
+
+/**
+ * INITIALIZE_PBST - creates an empty persistent tree
+ * Return: the tree or NULL on failure
+*/
+static PersistentBST *INITIALIZE_PBST(void)
+{
+    PersistentBST *tree = calloc(1, sizeof(PersistentBST));
+    if (tree == NULL) return (NULL);
+    pthread_mutex_init(&tree->write_lock, NULL);
+    pthread_mutex_init(&tree->root_lock, NULL);
+    return (tree);
+}
+
+/**
+ * delete_pbst - frees a tree
+ * @tree: the tree, no other thread may be using it. Snapshots taken from it
+ * stay valid until they are released
+*/
+static void delete_pbst(PersistentBST *tree)
+{
+    release(tree->root);
+    pthread_mutex_destroy(&tree->write_lock);
+    pthread_mutex_destroy(&tree->root_lock);
+    free(tree);
+}
+
+/**
+ * publish - makes a new root the latest version
+ * @tree: the tree, the caller holds write_lock
+ * @root: the new root, the tree takes over the caller's reference
+*/
+static void publish(PersistentBST *tree, BSTNode *root)
+{
+    pthread_mutex_lock(&tree->root_lock);
+    BSTNode *old_root = tree->root;
+    tree->root = root;
+    pthread_mutex_unlock(&tree->root_lock);
+    // the old version lives on for as long as snapshots of it do
+    release(old_root);
+}
+
+/**
+ * pbst_insert - inserts a value, making a new version of the tree
+ * @tree: the tree
+ * @value: the value to insert
+ * Return: true if the value was added, false if it was already in the tree
+ * or on allocation failure
+*/
+static bool pbst_insert(PersistentBST *tree, int value)
+{
+    bool inserted = false, failed = false;
+    pthread_mutex_lock(&tree->write_lock);
+    BSTNode *root = persistent_insert(tree->root, value, &inserted, &failed);
+    if (inserted && !failed)
+    {
+        publish(tree, root);
+        tree->count++;
+    }
+    else
+        release(root);
+    pthread_mutex_unlock(&tree->write_lock);
+    return (inserted && !failed);
+}
+
+/**
+ * pbst_delete - removes a value, making a new version of the tree
+ * @tree: the tree
+ * @value: the value to remove
+ * Return: true if the value was removed, false if it was not in the tree
+ * or on allocation failure
+*/
+static bool pbst_delete(PersistentBST *tree, int value)
+{
+    bool deleted = false, failed = false;
+    pthread_mutex_lock(&tree->write_lock);
+    BSTNode *root = persistent_delete(tree->root, value, &deleted, &failed);
+    if (deleted && !failed)
+    {
+        publish(tree, root);
+        tree->count--;
+    }
+    else
+        release(root);
+    pthread_mutex_unlock(&tree->write_lock);
+    return (deleted && !failed);
+}
+
+/**
+ * pbst_snapshot - takes a handle on the latest version of a tree
+ * @tree: the tree
+ * Return: the root of the version, NULL if it is empty. The version stays as
+ * it is, and in memory, until the handle is given to pbst_release
+*/
+static BSTNode *pbst_snapshot(PersistentBST *tree)
+{
+    pthread_mutex_lock(&tree->root_lock);
+    BSTNode *root = retain(tree->root);
+    pthread_mutex_unlock(&tree->root_lock);
+    return (root);
+}
+
+/**
+ * pbst_release - gives a snapshot back
+ * @snapshot: the handle from pbst_snapshot
+*/
+static void pbst_release(BSTNode *snapshot)
+{
+    release(snapshot);
+}
+
+/**
+ * pbst_contains - looks a value up in a snapshot
+ * @snapshot: the snapshot
+ * @value: the value to look for
+ * Return: true if the value is in that version of the tree
+*/
+static bool pbst_contains(const BSTNode *snapshot, int value)
+{
+    while (snapshot != NULL && snapshot->data != value)
+        snapshot = value < snapshot->data ? snapshot->left : snapshot->right;
+    return (snapshot != NULL);
+}
+
+/**
+ * pbst_inorder_traversal - performs inorder traversal on a snapshot
+ * @snapshot: the snapshot
+ * @function: function to be called on each node's value
+ * Description: the versions are balanced, so a fixed stack is enough
+*/
+static void pbst_inorder_traversal(const BSTNode *snapshot, void (*function)(int))
+{
+    const BSTNode *stack[MAX_HEIGHT];
+    size_t depth = 0;
+    while (snapshot != NULL || depth > 0)
+    {
+        for (; snapshot != NULL; snapshot = snapshot->left)
+            stack[depth++] = snapshot;
+        snapshot = stack[--depth];
+        function(snapshot->data);
+        snapshot = snapshot->right;
+    }
+}
+
+void print_number(int n)
+{
+    printf("%d ", n);
+}
+
+#define DEMO_VALUES 200000
+
+static long scanned_count;
+static long scanned_sum;
+
+void add_to_scan(int n)
+{
+    scanned_count++;
+    scanned_sum += n;
+}
+
+/**
+ * demo_writer - keeps inserting and deleting while the main thread reads
+ * @arg: the tree
+ * Return: NULL
+*/
+static void *demo_writer(void *arg)
+{
+    PersistentBST *tree = arg;
+    for (int i = 0; i < DEMO_VALUES; i++)
+        pbst_insert(tree, (int)((long long)i * 7919 % DEMO_VALUES));
+    for (int i = 0; i < DEMO_VALUES; i += 2)
+        pbst_delete(tree, i);
+    return (NULL);
+}
+
+int main()
+{
+    printf("Persistent BST in C\n");
+    PersistentBST *tree = INITIALIZE_PBST();
+    if (tree == NULL)
+        return (1);
+    for (int i = 1; i <= 10; i++)
+        pbst_insert(tree, i);
+    BSTNode *before = pbst_snapshot(tree);
+    pbst_delete(tree, 5);
+    pbst_insert(tree, 42);
+    BSTNode *after = pbst_snapshot(tree);
+    printf("Snapshot before the changes: ");
+    pbst_inorder_traversal(before, &print_number);
+    printf("\nSnapshot after the changes: ");
+    pbst_inorder_traversal(after, &print_number);
+    printf("\n5 is %sin the first one, %sin the second one\n", pbst_contains(before, 5) ? "" : "not ",
+           pbst_contains(after, 5) ? "" : "not ");
+    pbst_release(before);
+    pbst_release(after);
+
+    // scan snapshots while another thread keeps writing, each scan sees one whole version
+    pthread_t writer;
+    pthread_create(&writer, NULL, demo_writer, tree);
+    int consistent = 0, scans = 0;
+    for (; scans < 20; scans++)
+    {
+        BSTNode *snapshot = pbst_snapshot(tree);
+        scanned_count = scanned_sum = 0;
+        pbst_inorder_traversal(snapshot, &add_to_scan);
+        // walk it again, the writer cannot have changed it in between
+        const long count = scanned_count, sum = scanned_sum;
+        scanned_count = scanned_sum = 0;
+        pbst_inorder_traversal(snapshot, &add_to_scan);
+        consistent += count == scanned_count && sum == scanned_sum;
+        pbst_release(snapshot);
+    }
+    pthread_join(writer, NULL);
+    printf("%d of %d scans saw the same version twice\n", consistent, scans);
+    printf("count: %zu\n", tree->count);
+    delete_pbst(tree);
+    return (0);
+}
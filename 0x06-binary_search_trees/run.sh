@@ -1,3 +1,5 @@
 #!/usr/bin/bash
-gcc bst.c -o a
+# pass the file to build, defaults to bst.c
+# e.g ./run.sh persistent_bst.c
+gcc ${1:-bst.c} -pthread -o a
 ./a